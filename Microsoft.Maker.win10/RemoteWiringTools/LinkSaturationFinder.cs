@@ -0,0 +1,275 @@
+﻿using Microsoft.Maker.Firmata;
+using Microsoft.Maker.RemoteWiring;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Threading;
+
+namespace RemoteWiringTools
+{
+    public enum WorkloadOperation
+    {
+        DigitalWrite,
+        AnalogWrite,
+        DigitalReport,
+        AnalogReport,
+        I2cPoll
+    }
+
+    public enum LinkStage
+    {
+        HostToBoard,
+        BoardProcessing,
+        BoardToHost
+    }
+
+    /// <summary>
+    /// A single recurring operation of a planned configuration. Pin holds the I2C address for polls.
+    /// </summary>
+    public class WorkloadItem
+    {
+        public WorkloadOperation Operation;
+        public byte Pin;
+        public double RateHz;
+        public byte I2cBytes;
+    }
+
+    /// <summary>
+    /// A planned configuration and the characteristics of the link and board it will run on
+    /// </summary>
+    public class WorkloadConfiguration
+    {
+        public List<WorkloadItem> Items = new List<WorkloadItem>();
+        public uint BaudRate = 57600;
+        public double BoardMessageCostMicros = 100;
+        public int BoardBufferBytes = 64;
+        public double SimulatedSeconds = 2;
+    }
+
+    public class LoadStep
+    {
+        public double Load;
+        public double MeanLatencyMillis;
+        public double LossRate;
+        public Dictionary<LinkStage, double> Utilization = new Dictionary<LinkStage, double>();
+    }
+
+    /// <summary>
+    /// The bytes a single occurrence of a workload item costs on each direction of the link
+    /// </summary>
+    public class OperationCost
+    {
+        public int HostToBoardBytes;
+        public int BoardToHostBytes;
+    }
+
+    public class SaturationReport
+    {
+        public double SaturationLoad;
+        public LinkStage Bottleneck;
+        public List<OperationCost> Costs;
+        public List<LoadStep> Steps = new List<LoadStep>();
+    }
+
+    /// <summary>
+    /// Finds the load at which a planned configuration saturates its link. The bytes each operation costs are measured by issuing it
+    /// through a RemoteDevice connected over a MeteredStream, counting what the host writes and the size of the message the board
+    /// sends back. The workload is then replayed at increasing multiples of its planned rates through a rate-limited model of the
+    /// link and board on a virtual clock, until latency or loss rises sharply.
+    /// </summary>
+    public class LinkSaturationFinder
+    {
+        private const double LoadGrowth = 1.25;
+        private const double MaxLoad = 1000;
+        private const double LatencyKnee = 3.0;
+        private const double LossKnee = 0.01;
+        private const int BitsPerByte = 10;
+        private const int ReplyTimeoutMillis = 2000;
+
+        public static SaturationReport Find(RemoteDevice device, MeteredStream stream, WorkloadConfiguration config)
+        {
+            if (config.Items.Any(item => item.Operation == WorkloadOperation.I2cPoll))
+            {
+                device.I2c.enable();
+            }
+
+            var costs = config.Items.Select(item => measureCost(device, stream, item)).ToList();
+            var report = new SaturationReport();
+            report.Costs = costs;
+
+            double baselineLatency = 0;
+            for (double load = 1; load <= MaxLoad; load *= LoadGrowth)
+            {
+                var step = simulate(config, costs, load);
+                report.Steps.Add(step);
+
+                if (report.Steps.Count == 1)
+                {
+                    baselineLatency = step.MeanLatencyMillis;
+                }
+
+                // The first step at which latency or loss rises sharply is the saturation point, its busiest stage is the bottleneck
+                if (step.LossRate > LossKnee || step.MeanLatencyMillis > LatencyKnee * baselineLatency)
+                {
+                    report.SaturationLoad = load;
+                    report.Bottleneck = step.Utilization.OrderByDescending(stage => stage.Value).First().Key;
+                    return report;
+                }
+            }
+
+            var last = report.Steps.Last();
+            report.SaturationLoad = double.PositiveInfinity;
+            report.Bottleneck = last.Utilization.OrderByDescending(stage => stage.Value).First().Key;
+            return report;
+        }
+
+        private static OperationCost measureCost(RemoteDevice device, MeteredStream stream, WorkloadItem item)
+        {
+            var cost = new OperationCost();
+            long before;
+
+            switch (item.Operation)
+            {
+                case WorkloadOperation.DigitalWrite:
+                    device.pinMode(item.Pin, PinMode.OUTPUT);
+                    before = stream.BytesWritten;
+                    device.digitalWrite(item.Pin, PinState.HIGH);
+                    cost.HostToBoardBytes = (int)(stream.BytesWritten - before);
+                    break;
+
+                case WorkloadOperation.AnalogWrite:
+                    device.pinMode(item.Pin, PinMode.PWM);
+                    before = stream.BytesWritten;
+                    device.analogWrite(item.Pin, 128);
+                    cost.HostToBoardBytes = (int)(stream.BytesWritten - before);
+                    break;
+
+                case WorkloadOperation.DigitalReport:
+                    // The board reports the port as soon as reporting is enabled, each later report is the same size
+                    cost.BoardToHostBytes = awaitReply(
+                        () => device.pinMode(item.Pin, PinMode.INPUT),
+                        () => stream.MessagesRead(Command.DIGITAL_MESSAGE),
+                        () => stream.LastMessageBytes(Command.DIGITAL_MESSAGE));
+                    break;
+
+                case WorkloadOperation.AnalogReport:
+                    cost.BoardToHostBytes = awaitReply(
+                        () => device.pinMode(item.Pin, PinMode.ANALOG),
+                        () => stream.MessagesRead(Command.ANALOG_MESSAGE),
+                        () => stream.LastMessageBytes(Command.ANALOG_MESSAGE));
+                    break;
+
+                case WorkloadOperation.I2cPoll:
+                    before = stream.BytesWritten;
+                    cost.BoardToHostBytes = awaitReply(
+                        () => device.I2c.requestFrom(item.Pin, item.I2cBytes),
+                        () => stream.MessagesRead(SysexCommand.I2C_REPLY),
+                        () => stream.LastMessageBytes(SysexCommand.I2C_REPLY));
+                    cost.HostToBoardBytes = (int)(stream.BytesWritten - before);
+                    break;
+            }
+
+            return cost;
+        }
+
+        // Issues an operation and returns the size of the next message of the kind it causes the board to send
+        private static int awaitReply(Action issue, Func<int> messagesRead, Func<int> lastMessageBytes)
+        {
+            int before = messagesRead();
+            issue();
+
+            if (!SpinWait.SpinUntil(() => messagesRead() > before, ReplyTimeoutMillis))
+            {
+                throw new TimeoutException("The board did not send the message the operation should cause");
+            }
+            return lastMessageBytes();
+        }
+
+        private static LoadStep simulate(WorkloadConfiguration config, List<OperationCost> costs, double load)
+        {
+            var random = new Random(1);
+            double secondsPerByte = (double)BitsPerByte / config.BaudRate;
+            double boardCost = config.BoardMessageCostMicros / 1000000.0;
+
+            // Every operation recurs at its planned rate multiplied by the load, starting at a random phase
+            var arrivals = new List<Tuple<double, OperationCost>>();
+            for (int i = 0; i < config.Items.Count; ++i)
+            {
+                double period = 1.0 / (config.Items[i].RateHz * load);
+                for (double time = random.NextDouble() * period; time < config.SimulatedSeconds; time += period)
+                {
+                    arrivals.Add(Tuple.Create(time, costs[i]));
+                }
+            }
+            arrivals.Sort((a, b) => a.Item1.CompareTo(b.Item1));
+
+            var freeAt = new Dictionary<LinkStage, double>() { { LinkStage.HostToBoard, 0 }, { LinkStage.BoardProcessing, 0 }, { LinkStage.BoardToHost, 0 } };
+            var busy = new Dictionary<LinkStage, double>() { { LinkStage.HostToBoard, 0 }, { LinkStage.BoardProcessing, 0 }, { LinkStage.BoardToHost, 0 } };
+            var receiveBuffer = new List<Tuple<double, int>>();
+            var transmitBuffer = new List<Tuple<double, int>>();
+            Func<LinkStage, double, double, double> serve = (stage, ready, duration) =>
+            {
+                double start = Math.Max(ready, freeAt[stage]);
+                freeAt[stage] = start + duration;
+                busy[stage] += duration;
+                return start;
+            };
+
+            double totalLatency = 0;
+            int delivered = 0;
+            int lost = 0;
+            foreach (var arrival in arrivals)
+            {
+                double time = arrival.Item1;
+                var cost = arrival.Item2;
+
+                if (cost.HostToBoardBytes > 0)
+                {
+                    time = serve(LinkStage.HostToBoard, time, cost.HostToBoardBytes * secondsPerByte) + (cost.HostToBoardBytes * secondsPerByte);
+
+                    // Bytes wait in the board's receive buffer until the board begins processing them
+                    receiveBuffer.RemoveAll(waiting => waiting.Item1 <= time);
+                    if (receiveBuffer.Sum(waiting => waiting.Item2) + cost.HostToBoardBytes > config.BoardBufferBytes)
+                    {
+                        ++lost;
+                        continue;
+                    }
+                    double processing = serve(LinkStage.BoardProcessing, time, boardCost);
+                    receiveBuffer.Add(Tuple.Create(processing, cost.HostToBoardBytes));
+                    time = processing + boardCost;
+                }
+                else
+                {
+                    time = serve(LinkStage.BoardProcessing, time, boardCost) + boardCost;
+                }
+
+                if (cost.BoardToHostBytes > 0)
+                {
+                    // Replies and reports wait in the board's transmit buffer until the link is free
+                    transmitBuffer.RemoveAll(waiting => waiting.Item1 <= time);
+                    if (transmitBuffer.Sum(waiting => waiting.Item2) + cost.BoardToHostBytes > config.BoardBufferBytes)
+                    {
+                        ++lost;
+                        continue;
+                    }
+                    double sending = serve(LinkStage.BoardToHost, time, cost.BoardToHostBytes * secondsPerByte);
+                    transmitBuffer.Add(Tuple.Create(sending, cost.BoardToHostBytes));
+                    time = sending + (cost.BoardToHostBytes * secondsPerByte);
+                }
+
+                totalLatency += time - arrival.Item1;
+                ++delivered;
+            }
+
+            var step = new LoadStep();
+            step.Load = load;
+            step.MeanLatencyMillis = delivered > 0 ? (totalLatency / delivered) * 1000.0 : 0;
+            step.LossRate = arrivals.Count > 0 ? (double)lost / arrivals.Count : 0;
+            foreach (var stage in busy)
+            {
+                step.Utilization[stage.Key] = stage.Value / config.SimulatedSeconds;
+            }
+            return step;
+        }
+    }
+}
@@ -0,0 +1,281 @@
+﻿using Microsoft.Maker.Firmata;
+using Microsoft.Maker.Serial;
+using System;
+using System.Collections.Generic;
+
+namespace RemoteWiringTools
+{
+    /// <summary>
+    /// An IStream which passes everything through to another stream, counting the bytes written to it and measuring each Firmata
+    /// message read from it, so the traffic of an operation can be taken from what the board actually sends
+    /// </summary>
+    public class MeteredStream : IStream
+    {
+        // Sysex messages are keyed by their extended-command byte, offset past the range of command bytes
+        private const int SysexKeyOffset = 0x100;
+        private const int NoMessage = -1;
+        private const int AwaitingSysexCommand = -2;
+
+        private IStream stream;
+        private object meterLock = new object();
+        private long bytesWritten;
+        private Dictionary<int, int> messagesRead = new Dictionary<int, int>();
+        private Dictionary<int, int> lastMessageBytes = new Dictionary<int, int>();
+
+        // The message currently being read, the number of its bytes seen so far and the data bytes it still expects
+        private int messageKey = NoMessage;
+        private int messageBytes;
+        private int dataBytesRemaining;
+
+        public MeteredStream(IStream stream)
+        {
+            this.stream = stream;
+        }
+
+        public long BytesWritten
+        {
+            get
+            {
+                lock (this.meterLock)
+                {
+                    return this.bytesWritten;
+                }
+            }
+        }
+
+        /// <summary>
+        /// The number of complete messages with the given command which have been read. Channel messages are counted for all channels.
+        /// </summary>
+        public int MessagesRead(Command command)
+        {
+            return count(this.messagesRead, (int)command);
+        }
+
+        public int MessagesRead(SysexCommand command)
+        {
+            return count(this.messagesRead, SysexKeyOffset + (int)command);
+        }
+
+        /// <summary>
+        /// The size in bytes, including the command byte, of the last complete message with the given command which was read
+        /// </summary>
+        public int LastMessageBytes(Command command)
+        {
+            return count(this.lastMessageBytes, (int)command);
+        }
+
+        public int LastMessageBytes(SysexCommand command)
+        {
+            return count(this.lastMessageBytes, SysexKeyOffset + (int)command);
+        }
+
+        public event IStreamConnectionCallback ConnectionEstablished
+        {
+            add { this.stream.ConnectionEstablished += value; }
+            remove { this.stream.ConnectionEstablished -= value; }
+        }
+
+        public event IStreamConnectionCallbackWithMessage ConnectionFailed
+        {
+            add { this.stream.ConnectionFailed += value; }
+            remove { this.stream.ConnectionFailed -= value; }
+        }
+
+        public event IStreamConnectionCallbackWithMessage ConnectionLost
+        {
+            add { this.stream.ConnectionLost += value; }
+            remove { this.stream.ConnectionLost -= value; }
+        }
+
+        public ushort available()
+        {
+            return this.stream.available();
+        }
+
+        public void begin(uint baud_, SerialConfig config_)
+        {
+            this.stream.begin(baud_, config_);
+        }
+
+        public bool connectionReady()
+        {
+            return this.stream.connectionReady();
+        }
+
+        public void end()
+        {
+            this.stream.end();
+        }
+
+        public void flush()
+        {
+            this.stream.flush();
+        }
+
+        public void @lock()
+        {
+            this.stream.@lock();
+        }
+
+        public ushort read()
+        {
+            ushort data = this.stream.read();
+
+            // Values outside of a byte signify that nothing was available
+            if (data <= byte.MaxValue)
+            {
+                meter((byte)data);
+            }
+            return data;
+        }
+
+        public void unlock()
+        {
+            this.stream.unlock();
+        }
+
+        public ushort write(byte c_)
+        {
+            lock (this.meterLock)
+            {
+                ++this.bytesWritten;
+            }
+            return this.stream.write(c_);
+        }
+
+        public ushort write(byte[] buffer_)
+        {
+            lock (this.meterLock)
+            {
+                this.bytesWritten += buffer_.Length;
+            }
+            return this.stream.write(buffer_);
+        }
+
+        public ushort print(byte[] buffer_)
+        {
+            return this.stream.print(buffer_);
+        }
+
+        public ushort print(double value_, short decimal_place_)
+        {
+            return this.stream.print(value_, decimal_place_);
+        }
+
+        public ushort print(double value_)
+        {
+            return this.stream.print(value_);
+        }
+
+        public ushort print(uint value_, Radix base_)
+        {
+            return this.stream.print(value_, base_);
+        }
+
+        public ushort print(uint value_)
+        {
+            return this.stream.print(value_);
+        }
+
+        public ushort print(int value_, Radix base_)
+        {
+            return this.stream.print(value_, base_);
+        }
+
+        public ushort print(int value_)
+        {
+            return this.stream.print(value_);
+        }
+
+        public ushort print(byte c_)
+        {
+            return this.stream.print(c_);
+        }
+
+        private int count(Dictionary<int, int> counts, int key)
+        {
+            lock (this.meterLock)
+            {
+                int value;
+                return counts.TryGetValue(key, out value) ? value : 0;
+            }
+        }
+
+        private void meter(byte data)
+        {
+            lock (this.meterLock)
+            {
+                if (data == (byte)Command.END_SYSEX)
+                {
+                    if (this.messageKey >= SysexKeyOffset)
+                    {
+                        complete(this.messageBytes + 1);
+                    }
+                    this.messageKey = NoMessage;
+                    return;
+                }
+
+                // A command byte always begins a new message, abandoning any message which was incomplete
+                if (data >= 0x80)
+                {
+                    this.messageBytes = 1;
+                    if (data == (byte)Command.START_SYSEX)
+                    {
+                        this.messageKey = AwaitingSysexCommand;
+                        return;
+                    }
+
+                    // Only the upper nibble identifies commands below START_SYSEX, the lower nibble carries the port or pin
+                    this.messageKey = (data < (byte)Command.START_SYSEX) ? (data & 0xF0) : data;
+                    this.dataBytesRemaining = dataBytes((Command)this.messageKey);
+                    if (this.dataBytesRemaining == 0)
+                    {
+                        complete(this.messageBytes);
+                    }
+                    return;
+                }
+
+                if (this.messageKey == NoMessage) return;
+                ++this.messageBytes;
+
+                if (this.messageKey == AwaitingSysexCommand)
+                {
+                    this.messageKey = SysexKeyOffset + data;
+                }
+                else if (this.messageKey < SysexKeyOffset && --this.dataBytesRemaining == 0)
+                {
+                    complete(this.messageBytes);
+                }
+            }
+        }
+
+        private void complete(int bytes)
+        {
+            int read;
+            this.messagesRead.TryGetValue(this.messageKey, out read);
+            this.messagesRead[this.messageKey] = read + 1;
+            this.lastMessageBytes[this.messageKey] = bytes;
+            this.messageKey = NoMessage;
+        }
+
+        // The number of data bytes which follow each command, as they are parsed by UwpFirmata
+        private static int dataBytes(Command command)
+        {
+            switch (command)
+            {
+                case Command.DIGITAL_MESSAGE:
+                case Command.ANALOG_MESSAGE:
+                case Command.SET_PIN_MODE:
+                case Command.PROTOCOL_VERSION:
+                    return 2;
+
+                case Command.REPORT_ANALOG_PIN:
+                case Command.REPORT_DIGITAL_PIN:
+                    return 1;
+
+                default:
+                    return 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,74 @@
+﻿using Microsoft.Maker.Firmata;
+using Microsoft.Maker.RemoteWiring;
+using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace RemoteWiringUnitTests
+{
+    [TestClass]
+    public class AnalogHistoryTests
+    {
+        [TestMethod]
+        public async Task TestCompressedHistoryRoundTripsBatchedReports()
+        {
+            // Arrange
+            var pin = new MockPin(0);
+            pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.ANALOG, 10));
+            var board = new EmulatedBoard(new MockBoard(new List<MockPin>() { pin }));
+            var reported = new List<ushort>();
+
+            // Reports reach the device through the batched path, which carries the time each report was parsed
+            var hostFirmata = new UwpFirmata();
+            hostFirmata.setBatchReporting(true);
+            hostFirmata.begin(board.HostStream);
+
+            var ready = new ManualResetEventSlim();
+            var deviceUnderTest = new RemoteDevice(hostFirmata);
+            deviceUnderTest.DeviceReady += () => ready.Set();
+            Assert.IsTrue(ready.Wait(10000), "The emulated board did not complete the handshake");
+
+            deviceUnderTest.AnalogPinUpdated += (analogPin, value) =>
+            {
+                lock (reported)
+                {
+                    reported.Add(value);
+                }
+            };
+
+            // Act
+            var start = DateTimeOffset.UtcNow;
+            deviceUnderTest.setCompressedAnalogHistory("A0", 4096);
+            deviceUnderTest.pinMode("A0", PinMode.ANALOG);
+
+            // The value changes more slowly than it is sampled, so some reports repeat a value and some change it
+            for (ushort step = 0; step < 20; ++step)
+            {
+                board.Firmata.setAnalogValue(0, (ushort)((step * 37) & 0x3FF));
+                await Task.Delay(25);
+            }
+
+            // Reports must stop before the history is compared with the reports which were raised
+            board.Firmata.stopReporting();
+            await Task.Delay(100);
+            var samples = deviceUnderTest.getAnalogSamples("A0", start, DateTimeOffset.UtcNow);
+
+            // Assert
+            lock (reported)
+            {
+                Assert.IsTrue(reported.Count >= 10, "Too few reports were received to exercise the history");
+                CollectionAssert.AreEqual(reported.ToArray(), samples.Select(sample => sample.Value).ToArray(), "The history should decode to every reported value, in order");
+            }
+
+            for (int i = 1; i < samples.Length; ++i)
+            {
+                Assert.IsTrue(samples[i].Timestamp > samples[i - 1].Timestamp, "Each report should keep the time it was received");
+            }
+            Assert.IsTrue(samples.First().Timestamp >= start, "The first sample was stamped before reporting began");
+        }
+    }
+}
@@ -0,0 +1,59 @@
+﻿using Microsoft.Maker.RemoteWiring;
+using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace RemoteWiringUnitTests
+{
+    [TestClass]
+    public class BoardStateTests
+    {
+        [TestMethod]
+        public async Task TestApplyStateSendsOnlyChanges()
+        {
+            // Arrange
+            RemoteDevice deviceUnderTest = null;
+            RemoteDeviceHelper deviceHelper = new RemoteDeviceHelper();
+            byte inputPin = 0;
+            byte outputPin = 1;
+
+            var pins = new List<MockPin>() { new MockPin(inputPin), new MockPin(outputPin) };
+            foreach (var pin in pins)
+            {
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.INPUT, 1));
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.OUTPUT, 1));
+            }
+
+            var board = new MockBoard(pins);
+
+            var desiredState = new BoardState();
+            desiredState.setPinMode(inputPin, PinMode.INPUT);
+            desiredState.setPinMode(outputPin, PinMode.OUTPUT);
+            desiredState.setDigitalState(outputPin, PinState.HIGH);
+
+            // Act
+            deviceUnderTest = deviceHelper.CreateDeviceUnderTestAndConnect(board);
+
+            // Wait until the mock board is ready
+            SpinWait.SpinUntil(() => { return deviceHelper.DeviceState == DeviceState.Ready; }, 100000);
+
+            var firstSummary = deviceUnderTest.applyState(desiredState);
+
+            // Wait for the mock board to recieve the state change
+            await Task.Delay(100);
+
+            var secondSummary = deviceUnderTest.applyState(desiredState);
+
+            // Assert
+            Assert.AreEqual(1, firstSummary.PinModesChanged, "Only the input pin should have changed modes");
+            Assert.AreEqual(1, firstSummary.DigitalPortsChanged, "The output port should have changed");
+            Assert.AreEqual(PinMode.INPUT, board.Pins[inputPin].CurrentMode, "Pin mode was not communicated to board properly");
+            Assert.AreEqual(PinState.HIGH, (PinState)board.Pins[outputPin].CurrentValue, "Pin state was incorrect");
+            Assert.AreEqual(0, secondSummary.MessagesSent, "An unchanged state should not send any messages");
+        }
+    }
+}
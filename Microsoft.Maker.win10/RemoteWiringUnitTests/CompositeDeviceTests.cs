@@ -0,0 +1,95 @@
+﻿using Microsoft.Maker.RemoteWiring;
+using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace RemoteWiringUnitTests
+{
+    [TestClass]
+    public class CompositeDeviceTests
+    {
+        private static EmulatedBoard createBoard(int pinCount)
+        {
+            var pins = new List<MockPin>();
+            for (uint pinNumber = 0; pinNumber < pinCount; ++pinNumber)
+            {
+                var pin = new MockPin(pinNumber);
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.INPUT, 1));
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.OUTPUT, 1));
+                pins.Add(pin);
+            }
+
+            return new EmulatedBoard(new MockBoard(pins));
+        }
+
+        [TestMethod]
+        public async Task TestCompositePinsMapToMembers()
+        {
+            // Arrange
+            var firstBoard = createBoard(3);
+            var secondBoard = createBoard(2);
+            ushort writtenPortValue = 0;
+            secondBoard.Firmata.DigitalPortWriteRequested += (caller, argv) => { writtenPortValue = argv.getValue(); };
+
+            // Act
+            var composite = new CompositeDevice(new List<RemoteDevice>() { firstBoard.ConnectHost(), secondBoard.ConnectHost() });
+
+            composite.pinMode(1, PinMode.INPUT);
+            composite.pinMode(4, PinMode.OUTPUT);
+            composite.digitalWrite(4, PinState.HIGH);
+
+            // Wait for the boards to recieve the changes
+            await Task.Delay(200);
+
+            // Assert
+            Assert.AreEqual(5, composite.TotalPinCount, "The composite should span the pins of both members");
+            Assert.AreEqual(PinMode.INPUT, firstBoard.Board.Pins[1].CurrentMode, "Composite pin 1 should be pin 1 of the first member");
+            Assert.AreEqual(PinMode.OUTPUT, secondBoard.Board.Pins[1].CurrentMode, "Composite pin 4 should be pin 1 of the second member");
+            Assert.AreEqual(PinMode.IGNORED, secondBoard.Board.Pins[0].CurrentMode, "No other pin of the second member should have changed");
+            Assert.AreEqual(0x02, writtenPortValue, "The write should set pin 1 of the second member");
+            Assert.AreEqual(PinMode.OUTPUT, composite.getPinMode(4), "The mode should be read back from the second member");
+        }
+
+        [TestMethod]
+        public async Task TestCompositeMergesMemberUpdates()
+        {
+            // Arrange
+            var firstBoard = createBoard(3);
+            var secondBoard = createBoard(2);
+            var updates = new List<Tuple<ushort, PinState>>();
+
+            // Act
+            var composite = new CompositeDevice(new List<RemoteDevice>() { firstBoard.ConnectHost(), secondBoard.ConnectHost() });
+            composite.DigitalPinUpdated += (pin, state) =>
+            {
+                lock (updates)
+                {
+                    updates.Add(Tuple.Create(pin, state));
+                }
+            };
+
+            composite.pinMode(0, PinMode.INPUT);
+            composite.pinMode(4, PinMode.INPUT);
+
+            // Wait for the boards to begin reporting, then change an input of each
+            await Task.Delay(100);
+            firstBoard.Firmata.setDigitalPortValue(0, 0x01);
+            secondBoard.Firmata.setDigitalPortValue(0, 0x02);
+
+            // Wait for the next scheduled reports
+            await Task.Delay(200);
+
+            // Assert
+            lock (updates)
+            {
+                Assert.AreEqual(2, updates.Count, "Each member should raise exactly one update");
+                Assert.IsTrue(updates.Contains(Tuple.Create((ushort)0, PinState.HIGH)), "Pin 0 of the first member should be raised as composite pin 0");
+                Assert.IsTrue(updates.Contains(Tuple.Create((ushort)4, PinState.HIGH)), "Pin 1 of the second member should be raised as composite pin 4");
+            }
+        }
+    }
+}
@@ -0,0 +1,58 @@
+﻿using Microsoft.Maker.Firmata;
+using Microsoft.Maker.RemoteWiring;
+using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace RemoteWiringUnitTests
+{
+    [TestClass]
+    public class DeviceRoleTests
+    {
+        [TestMethod]
+        public async Task TestHostDigitalWriteIsRaisedAsWriteRequest()
+        {
+            // Arrange
+            RemoteDevice deviceUnderTest = null;
+            byte outputPin = 0;
+            byte inputPin = 1;
+            int writeRequests = 0;
+            int reportsRaised = 0;
+            ushort writtenPortValue = 0;
+
+            var pins = new List<MockPin>() { new MockPin(outputPin), new MockPin(inputPin) };
+            foreach (var pin in pins)
+            {
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.INPUT, 1));
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.OUTPUT, 1));
+            }
+
+            var board = new EmulatedBoard(new MockBoard(pins));
+            board.Firmata.DigitalPortWriteRequested += (caller, argv) => { writtenPortValue = argv.getValue(); ++writeRequests; };
+            board.Firmata.DigitalPortValueUpdated += (caller, argv) => { ++reportsRaised; };
+
+            // Act
+            deviceUnderTest = board.ConnectHost();
+
+            deviceUnderTest.pinMode(outputPin, PinMode.OUTPUT);
+            deviceUnderTest.digitalWrite(outputPin, PinState.HIGH);
+
+            // Enabling reporting for the port makes the board report its current value
+            deviceUnderTest.pinMode(inputPin, PinMode.INPUT);
+
+            // Wait for the board to recieve the write and send its next report
+            await Task.Delay(200);
+
+            // Assert
+            Assert.AreEqual(PinMode.OUTPUT, board.Board.Pins[outputPin].CurrentMode, "Pin mode was not raised to the board");
+            Assert.AreEqual(1, writeRequests, "The host write should be raised as a single write request");
+            Assert.AreEqual(0x01, writtenPortValue, "The write request carried the wrong port value");
+            Assert.AreEqual(0, reportsRaised, "A host write must not be raised as a report");
+            Assert.IsTrue(board.BoardStream.SentSequence((byte)Command.DIGITAL_MESSAGE, 0x01, 0x00), "The board's report should carry the value written by the host");
+        }
+    }
+}
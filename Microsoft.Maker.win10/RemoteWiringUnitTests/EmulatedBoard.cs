@@ -0,0 +1,121 @@
+﻿using Microsoft.Maker.Firmata;
+using Microsoft.Maker.RemoteWiring;
+using Microsoft.Maker.Serial;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Threading;
+using Windows.Storage.Streams;
+
+namespace RemoteWiringUnitTests
+{
+    /// <summary>
+    /// A board emulated by a UwpFirmata instance in the device role, linked to its host by a pair of loopback streams
+    /// </summary>
+    public class EmulatedBoard
+    {
+        // The read mode of an I2C request, given in the byte after the address
+        private const byte I2cReadOnceMask = 0x08;
+        private const byte I2cReadWriteModeMask = 0x18;
+
+        public UwpFirmata Firmata;
+        public LoopbackStream HostStream;
+        public LoopbackStream BoardStream;
+        public MockBoard Board;
+
+        public EmulatedBoard(MockBoard board)
+        {
+            this.Board = board;
+            LoopbackStream.CreatePair(out this.HostStream, out this.BoardStream);
+
+            this.Firmata = new UwpFirmata();
+            this.Firmata.SysexMessageReceived += OnSysexMessageReceived;
+            this.Firmata.PinModeRequested += OnPinModeRequested;
+            this.Firmata.begin(this.BoardStream);
+            this.Firmata.startListening();
+            this.Firmata.startReporting();
+        }
+
+        public RemoteDevice ConnectHost()
+        {
+            return ConnectHost(this.HostStream);
+        }
+
+        /// <summary>
+        /// Connects a host through the given stream, which must pass its traffic through to the host end of the loopback pair
+        /// </summary>
+        public RemoteDevice ConnectHost(IStream hostStream)
+        {
+            var ready = new ManualResetEventSlim();
+            var device = new RemoteDevice(hostStream);
+            device.DeviceReady += () => ready.Set();
+
+            // Wait for the handshake to complete
+            ready.Wait(10000);
+            return device;
+        }
+
+        private void OnPinModeRequested(UwpFirmata caller, CallbackEventArgs argv)
+        {
+            if (argv.getPort() < this.Board.Pins.Count)
+            {
+                this.Board.Pins[argv.getPort()].CurrentMode = (PinMode)argv.getValue();
+            }
+        }
+
+        private void OnSysexMessageReceived(UwpFirmata caller, SysexCallbackEventArgs argv)
+        {
+            if (argv.getCommand() == (byte)SysexCommand.I2C_REQUEST)
+            {
+                answerI2cRead(caller, argv.getDataBuffer());
+                return;
+            }
+
+            if (argv.getCommand() != (byte)SysexCommand.CAPABILITY_QUERY) return;
+
+            var writer = new DataWriter();
+            foreach (var pin in this.Board.Pins)
+            {
+                foreach (var mode in pin.SupportedModes)
+                {
+                    writer.WriteByte((byte)mode.Key);
+                    writer.WriteByte((byte)mode.Value);
+                }
+
+                writer.WriteByte(127);
+            }
+
+            caller.sendSysex(SysexCommand.CAPABILITY_RESPONSE, writer.DetachBuffer());
+        }
+
+        // Read requests are answered with zeros, the payload holds the register and byte count, each as two 7-bit bytes
+        private static void answerI2cRead(UwpFirmata caller, IBuffer request)
+        {
+            var reader = DataReader.FromBuffer(request);
+            if (reader.UnconsumedBufferLength < 4) return;
+
+            byte address = reader.ReadByte();
+            byte mode = reader.ReadByte();
+            if ((mode & I2cReadWriteModeMask) != I2cReadOnceMask) return;
+
+            var values = new List<byte>();
+            while (reader.UnconsumedBufferLength >= 2)
+            {
+                values.Add((byte)(reader.ReadByte() | (reader.ReadByte() << 7)));
+            }
+
+            // A request without a register reads from register 0
+            byte register = (values.Count > 1) ? values[0] : (byte)0;
+            byte count = values.Last();
+
+            var writer = new DataWriter();
+            foreach (byte value in new byte[] { address, register }.Concat(new byte[count]))
+            {
+                writer.WriteByte((byte)(value & 0x7F));
+                writer.WriteByte((byte)(value >> 7));
+            }
+
+            caller.sendSysex(SysexCommand.I2C_REPLY, writer.DetachBuffer());
+        }
+    }
+}
@@ -0,0 +1,94 @@
+﻿using Microsoft.Maker.Firmata;
+using Microsoft.Maker.RemoteWiring;
+using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Windows.Storage.Streams;
+
+namespace RemoteWiringUnitTests
+{
+    [TestClass]
+    public class KeypadTests
+    {
+        private const byte KeypadConfig = 0x00;
+        private const byte KeypadEvent = 0x01;
+
+        private static void sendKeyEvents(EmulatedBoard board, params byte[] keyStates)
+        {
+            var writer = new DataWriter();
+            writer.WriteByte(KeypadEvent);
+            writer.WriteBytes(keyStates);
+            board.Firmata.sendSysex(SysexCommand.KEYPAD_DATA, writer.DetachBuffer());
+        }
+
+        [TestMethod]
+        public async Task TestKeypadIsConfiguredAndRaisesKeyChanges()
+        {
+            // Arrange
+            var pins = new List<MockPin>();
+            for (uint pinNumber = 0; pinNumber < 7; ++pinNumber)
+            {
+                var pin = new MockPin(pinNumber);
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.INPUT, 1));
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.OUTPUT, 1));
+                pins.Add(pin);
+            }
+
+            var board = new EmulatedBoard(new MockBoard(pins));
+            byte[] configuration = null;
+            board.Firmata.SysexMessageReceived += (caller, argv) =>
+            {
+                if (argv.getCommand() != (byte)SysexCommand.KEYPAD_DATA) return;
+
+                var reader = DataReader.FromBuffer(argv.getDataBuffer());
+                var payload = new byte[reader.UnconsumedBufferLength];
+                reader.ReadBytes(payload);
+                configuration = payload;
+            };
+
+            var changes = new List<Tuple<byte, byte, bool>>();
+            var deviceUnderTest = board.ConnectHost();
+            deviceUnderTest.Keypad.KeyStateChanged += (row, column, pressed) =>
+            {
+                lock (changes)
+                {
+                    changes.Add(Tuple.Create(row, column, pressed));
+                }
+            };
+
+            // Act
+            // A 4x3 matrix with rows on pins 0-3, columns on pins 4-6 and a debounce time which needs both 7-bit bytes
+            deviceUnderTest.Keypad.begin(new byte[] { 0, 1, 2, 3 }, new byte[] { 4, 5, 6 }, 200);
+            await Task.Delay(100);
+
+            // Row 2, column 1 is pressed, reported again while held, then released along with a press of row 0, column 0
+            sendKeyEvents(board, (2 << 3) | 1, 1);
+            await Task.Delay(50);
+            bool downWhileHeld = deviceUnderTest.Keypad.isKeyDown(2, 1);
+            sendKeyEvents(board, (2 << 3) | 1, 1);
+            sendKeyEvents(board, (2 << 3) | 1, 0, 0, 1);
+            await Task.Delay(100);
+
+            // Assert
+            CollectionAssert.AreEqual(new byte[] { KeypadConfig, 4, 3, 0, 1, 2, 3, 4, 5, 6, 200 & 0x7F, 200 >> 7 }, configuration, "The board received the wrong configuration");
+            Assert.IsTrue(downWhileHeld, "The key should be down once its press has been reported");
+            Assert.IsFalse(deviceUnderTest.Keypad.isKeyDown(2, 1), "The key should be up once its release has been reported");
+            Assert.IsTrue(deviceUnderTest.Keypad.isKeyDown(0, 0), "A second key in the same message should be applied");
+
+            var expected = new List<Tuple<byte, byte, bool>>()
+            {
+                Tuple.Create((byte)2, (byte)1, true),
+                Tuple.Create((byte)2, (byte)1, false),
+                Tuple.Create((byte)0, (byte)0, true),
+            };
+            lock (changes)
+            {
+                CollectionAssert.AreEqual(expected, changes, "Each change should be raised once, a repeated press must not be raised again");
+            }
+        }
+    }
+}
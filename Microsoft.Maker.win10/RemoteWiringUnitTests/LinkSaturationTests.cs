@@ -0,0 +1,73 @@
+﻿using Microsoft.Maker.RemoteWiring;
+using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
+using RemoteWiringTools;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace RemoteWiringUnitTests
+{
+    [TestClass]
+    public class LinkSaturationTests
+    {
+        [TestMethod]
+        public void TestAnalogReportsSaturateBoardToHostLink()
+        {
+            // Arrange
+            var config = new WorkloadConfiguration();
+
+            var pins = new List<MockPin>();
+            for (byte pinNumber = 0; pinNumber < 6; ++pinNumber)
+            {
+                var pin = new MockPin(pinNumber);
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.ANALOG, 10));
+                pins.Add(pin);
+
+                config.Items.Add(new WorkloadItem() { Operation = WorkloadOperation.AnalogReport, Pin = pinNumber, RateHz = 50 });
+            }
+
+            var board = new EmulatedBoard(new MockBoard(pins));
+            var stream = new MeteredStream(board.HostStream);
+
+            // Act
+            var deviceUnderTest = board.ConnectHost(stream);
+            var report = LinkSaturationFinder.Find(deviceUnderTest, stream, config);
+
+            // Assert
+            Assert.IsTrue(report.Costs.All(cost => cost.BoardToHostBytes == 3 && cost.HostToBoardBytes == 0), "Each analog report the board sent should have been measured as 3 bytes");
+
+            // 6 channels at 50Hz send 900 bytes per second over a link which carries 5760, so the link saturates at roughly 6.4 times the planned load
+            Assert.AreEqual(LinkStage.BoardToHost, report.Bottleneck, "Analog reports should saturate the link from the board");
+            Assert.IsTrue(report.SaturationLoad > 4 && report.SaturationLoad < 10, "Saturation was found at an unexpected load");
+        }
+
+        [TestMethod]
+        public void TestI2cPollCostIsMeasuredFromTheReply()
+        {
+            // Arrange
+            const byte readBytes = 4;
+            var config = new WorkloadConfiguration();
+            config.Items.Add(new WorkloadItem() { Operation = WorkloadOperation.I2cPoll, Pin = 0x40, I2cBytes = readBytes, RateHz = 100 });
+
+            var pin = new MockPin(0);
+            pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.I2C, 1));
+            var board = new EmulatedBoard(new MockBoard(new List<MockPin>() { pin }));
+            var stream = new MeteredStream(board.HostStream);
+
+            // Act
+            var deviceUnderTest = board.ConnectHost(stream);
+            var report = LinkSaturationFinder.Find(deviceUnderTest, stream, config);
+
+            // Assert
+            // START_SYSEX, I2C_REQUEST, address, mode, the byte count as two 7-bit bytes and END_SYSEX
+            Assert.AreEqual(7, report.Costs[0].HostToBoardBytes, "The request should have been measured as written");
+
+            // START_SYSEX, I2C_REPLY, address, register and each data byte as two 7-bit bytes, END_SYSEX
+            Assert.AreEqual(7 + (2 * readBytes), report.Costs[0].BoardToHostBytes, "The reply should have been measured as the board sent it");
+            Assert.AreEqual(LinkStage.BoardToHost, report.Bottleneck, "Replies are larger than requests, so the link from the board should saturate first");
+        }
+    }
+}
@@ -0,0 +1,210 @@
+﻿using Microsoft.Maker.Serial;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Threading;
+
+namespace RemoteWiringUnitTests
+{
+    /// <summary>
+    /// One end of an in-memory link. Bytes flushed from one end become available to be read from the other, so a host and an emulated board can be connected without hardware.
+    /// </summary>
+    public class LoopbackStream : IStream
+    {
+        // Test Values
+        public bool ConnectionReady;
+        public List<byte> Sent;
+
+        private LoopbackStream peer;
+        private Queue<byte> inbound;
+        private List<byte> outbound;
+        private object streamLock;
+
+        public event IStreamConnectionCallback ConnectionEstablished;
+        public event IStreamConnectionCallbackWithMessage ConnectionFailed;
+        public event IStreamConnectionCallbackWithMessage ConnectionLost;
+
+        private LoopbackStream()
+        {
+            this.ConnectionReady = true;
+            this.Sent = new List<byte>();
+            this.inbound = new Queue<byte>();
+            this.outbound = new List<byte>();
+            this.streamLock = new object();
+        }
+
+        public static void CreatePair(out LoopbackStream host, out LoopbackStream board)
+        {
+            host = new LoopbackStream();
+            board = new LoopbackStream();
+            host.peer = board;
+            board.peer = host;
+        }
+
+        /// <summary>
+        /// Drops the link, bytes which have not been read are lost
+        /// </summary>
+        public void Disconnect()
+        {
+            var ends = new LoopbackStream[] { this, this.peer };
+            foreach (var end in ends)
+            {
+                lock (end.inbound)
+                {
+                    end.inbound.Clear();
+                }
+                end.ConnectionReady = false;
+            }
+
+            foreach (var end in ends)
+            {
+                end.ConnectionLost?.Invoke("The loopback link was disconnected");
+            }
+        }
+
+        /// <summary>
+        /// Restores the link, both ends are ready before either is told the connection was established
+        /// </summary>
+        public void Reconnect()
+        {
+            var ends = new LoopbackStream[] { this, this.peer };
+            foreach (var end in ends)
+            {
+                end.ConnectionReady = true;
+            }
+
+            foreach (var end in ends)
+            {
+                end.ConnectionEstablished?.Invoke();
+            }
+        }
+
+        public bool SentSequence(params byte[] sequence)
+        {
+            byte[] sent;
+            lock (this.Sent)
+            {
+                sent = this.Sent.ToArray();
+            }
+
+            for (int i = 0; i + sequence.Length <= sent.Length; ++i)
+            {
+                if (sent.Skip(i).Take(sequence.Length).SequenceEqual(sequence)) return true;
+            }
+            return false;
+        }
+
+        public ushort available()
+        {
+            lock (this.inbound)
+            {
+                return (ushort)Math.Min(this.inbound.Count, ushort.MaxValue);
+            }
+        }
+
+        public void begin(uint baud_, SerialConfig config_)
+        {
+        }
+
+        public bool connectionReady()
+        {
+            return this.ConnectionReady;
+        }
+
+        public void end()
+        {
+        }
+
+        public void flush()
+        {
+            byte[] frame = this.outbound.ToArray();
+            this.outbound.Clear();
+            if (!this.ConnectionReady) return;
+
+            lock (this.Sent)
+            {
+                this.Sent.AddRange(frame);
+            }
+
+            lock (this.peer.inbound)
+            {
+                foreach (var c in frame)
+                {
+                    this.peer.inbound.Enqueue(c);
+                }
+            }
+        }
+
+        public void @lock()
+        {
+            Monitor.Enter(this.streamLock);
+        }
+
+        public ushort read()
+        {
+            lock (this.inbound)
+            {
+                // This value signifies that nothing is available
+                if (this.inbound.Count == 0) return 65535;
+                return this.inbound.Dequeue();
+            }
+        }
+
+        public void unlock()
+        {
+            Monitor.Exit(this.streamLock);
+        }
+
+        public ushort write(byte c_)
+        {
+            this.outbound.Add(c_);
+            return 1;
+        }
+
+        public ushort write(byte[] buffer_)
+        {
+            this.outbound.AddRange(buffer_);
+            return (ushort)buffer_.Length;
+        }
+
+        public ushort print(byte[] buffer_)
+        {
+            throw new NotImplementedException();
+        }
+
+        public ushort print(double value_, short decimal_place_)
+        {
+            throw new NotImplementedException();
+        }
+
+        public ushort print(double value_)
+        {
+            throw new NotImplementedException();
+        }
+
+        public ushort print(uint value_, Radix base_)
+        {
+            throw new NotImplementedException();
+        }
+
+        public ushort print(uint value_)
+        {
+            throw new NotImplementedException();
+        }
+
+        public ushort print(int value_, Radix base_)
+        {
+            throw new NotImplementedException();
+        }
+
+        public ushort print(int value_)
+        {
+            throw new NotImplementedException();
+        }
+
+        public ushort print(byte c_)
+        {
+            throw new NotImplementedException();
+        }
+    }
+}
@@ -71,24 +71,47 @@ namespace RemoteWiringUnitTests
         {
             this.LastFlushedReadBuffer = new List<UInt16>(this.ActiveReadBuffer);
             this.ActiveReadBuffer.Clear();
-            if (this.LastFlushedReadBuffer.Count == 0) return;
 
-            bool isSysEx = false;
+            // A single flush may carry several messages, each one is applied to the board in order
+            int index = 0;
+            while (index < this.LastFlushedReadBuffer.Count)
+            {
+                index += this.processMessage(index);
+            }
+
+            this.LastFlushedReadBuffer.Clear();
+        }
 
-            Command command = (Command)this.LastFlushedReadBuffer[0];
+        private int processMessage(int index)
+        {
+            var buffer = this.LastFlushedReadBuffer;
+            ushort commandByte = buffer[index];
 
-            switch(command)
+            // Only the upper nibble identifies commands below START_SYSEX, the lower nibble carries the port or pin
+            Command command = (Command)(commandByte < (ushort)Command.START_SYSEX ? (commandByte & 0xF0) : commandByte);
+
+            switch (command)
             {
                 case Command.START_SYSEX:
-                    isSysEx = true;
-                    break;
+                    int end = buffer.IndexOf((ushort)Command.END_SYSEX, index);
+                    if (end < 0) return buffer.Count - index;
+
+                    switch ((SysexCommand)buffer[index + 1])
+                    {
+                        case SysexCommand.CAPABILITY_QUERY:
+                            this.sendMessage(prepareCapabilityResponseMessage(this.Board));
+                            break;
+                    }
+                    return end - index + 1;
+
                 case Command.SET_PIN_MODE:
-                    this.Board.Pins[this.LastFlushedReadBuffer[1]].CurrentMode = (PinMode)this.LastFlushedReadBuffer[2];
-                    break;
+                    this.Board.Pins[buffer[index + 1]].CurrentMode = (PinMode)buffer[index + 2];
+                    return 3;
+
                 case Command.DIGITAL_MESSAGE:
-                    var portNumber = this.LastFlushedReadBuffer[0] & 0xF;
+                    var portNumber = commandByte & 0xF;
 
-                    ushort portValue = (ushort)(this.LastFlushedReadBuffer[1] | (this.LastFlushedReadBuffer[2] << 7));
+                    ushort portValue = (ushort)(buffer[index + 1] | (buffer[index + 2] << 7));
                     var pinValue = new BitArray(BitConverter.GetBytes(portValue));
 
                     var totalPins = this.Board.Pins.Count();
@@ -98,20 +121,18 @@ namespace RemoteWiringUnitTests
                     {
                         this.Board.Pins[pinCounter].CurrentValue = Convert.ToUInt16(pinValue[pinCounter - offset]);
                     }
-                    break;
-            }
+                    return 3;
 
-            if (isSysEx)
-            {
-                switch ((SysexCommand)this.LastFlushedReadBuffer[1])
-                {
-                    case SysexCommand.CAPABILITY_QUERY:
-                        this.sendMessage(prepareCapabilityResponseMessage(this.Board));
-                        break;
-                }
-            }
+                case Command.ANALOG_MESSAGE:
+                    return 3;
 
-            this.LastFlushedReadBuffer.Clear();
+                case Command.REPORT_ANALOG_PIN:
+                case Command.REPORT_DIGITAL_PIN:
+                    return 2;
+
+                default:
+                    return 1;
+            }
         }
 
         public void @lock()
@@ -255,7 +276,8 @@ namespace RemoteWiringUnitTests
 
         public ushort write(byte[] buffer_)
         {
-            throw new NotImplementedException();
+            this.ActiveReadBuffer.AddRange(buffer_.Select(c_ => (UInt16)c_));
+            return (ushort)buffer_.Length;
         }
     }
 }
@@ -0,0 +1,97 @@
+﻿using Microsoft.Maker.Firmata;
+using Microsoft.Maker.RemoteWiring;
+using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Windows.Storage.Streams;
+
+namespace RemoteWiringUnitTests
+{
+    [TestClass]
+    public class MultiplexerTests
+    {
+        private const byte MuxAddress = 0x70;
+
+        // Records every I2C write the board receives as ( address, first data byte )
+        private static List<Tuple<byte, byte>> recordWrites(EmulatedBoard board)
+        {
+            var writes = new List<Tuple<byte, byte>>();
+            board.Firmata.SysexMessageReceived += (caller, argv) =>
+            {
+                if (argv.getCommand() != (byte)SysexCommand.I2C_REQUEST) return;
+
+                var reader = DataReader.FromBuffer(argv.getDataBuffer());
+                if (reader.UnconsumedBufferLength < 4) return;
+
+                byte address = reader.ReadByte();
+                byte mode = reader.ReadByte();
+                if (mode != 0) return;
+
+                byte data = (byte)(reader.ReadByte() | (reader.ReadByte() << 7));
+                lock (writes)
+                {
+                    writes.Add(Tuple.Create(address, data));
+                }
+            };
+            return writes;
+        }
+
+        private static void waitForWrites(List<Tuple<byte, byte>> writes, int count)
+        {
+            SpinWait.SpinUntil(() => { lock (writes) { return writes.Count >= count; } }, 2000);
+        }
+
+        [TestMethod]
+        public void TestQueuedTransactionsAreGroupedByChannel()
+        {
+            // Arrange
+            var board = new EmulatedBoard(new MockBoard(new List<MockPin>() { new MockPin(0) }));
+            var writes = recordWrites(board);
+            var deviceUnderTest = board.ConnectHost();
+            var i2c = deviceUnderTest.I2c;
+
+            // Two identical devices behind different channels, and a second device behind the first channel
+            ushort first = i2c.registerMultiplexedDevice(MuxAddress, 0, 0x40);
+            ushort second = i2c.registerMultiplexedDevice(MuxAddress, 1, 0x40);
+            ushort third = i2c.registerMultiplexedDevice(MuxAddress, 0, 0x41);
+
+            // Act
+            i2c.queueWrite(first, new byte[] { 0x01 });
+            i2c.queueWrite(second, new byte[] { 0x02 });
+            i2c.queueWrite(third, new byte[] { 0x03 });
+            i2c.queueWrite(second, new byte[] { 0x04 });
+            i2c.queueWrite(first, new byte[] { 0x05 });
+            i2c.sendQueuedTransactions();
+
+            // The channel left selected by the previous call is scheduled first, without being selected again
+            i2c.queueWrite(first, new byte[] { 0x06 });
+            i2c.queueWrite(second, new byte[] { 0x07 });
+            i2c.sendQueuedTransactions();
+
+            var expected = new List<Tuple<byte, byte>>()
+            {
+                Tuple.Create(MuxAddress, (byte)0x01),
+                Tuple.Create((byte)0x40, (byte)0x01),
+                Tuple.Create((byte)0x41, (byte)0x03),
+                Tuple.Create((byte)0x40, (byte)0x05),
+                Tuple.Create(MuxAddress, (byte)0x02),
+                Tuple.Create((byte)0x40, (byte)0x02),
+                Tuple.Create((byte)0x40, (byte)0x04),
+                Tuple.Create((byte)0x40, (byte)0x07),
+                Tuple.Create(MuxAddress, (byte)0x01),
+                Tuple.Create((byte)0x40, (byte)0x06),
+            };
+            waitForWrites(writes, expected.Count);
+
+            // Assert
+            lock (writes)
+            {
+                CollectionAssert.AreEqual(expected, writes, "Transactions should be grouped by channel, keeping the order of each device, with a select only when the channel changes");
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+﻿using Microsoft.Maker.Firmata;
+using Microsoft.Maker.RemoteWiring;
+using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace RemoteWiringUnitTests
+{
+    [TestClass]
+    public class ShadowStateTests
+    {
+        [TestMethod]
+        public async Task TestWritesWhileDisconnectedAreReplayedOnReconnect()
+        {
+            // Arrange
+            RemoteDevice deviceUnderTest = null;
+            byte outputPin = 0;
+            byte inputPin = 1;
+            int writeRequests = 0;
+            ushort writtenPortValue = 0;
+
+            var pins = new List<MockPin>() { new MockPin(outputPin), new MockPin(inputPin) };
+            foreach (var pin in pins)
+            {
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.INPUT, 1));
+                pin.SupportedModes.Add(new KeyValuePair<PinMode, ushort>(PinMode.OUTPUT, 1));
+            }
+
+            var board = new EmulatedBoard(new MockBoard(pins));
+            board.Firmata.DigitalPortWriteRequested += (caller, argv) => { writtenPortValue = argv.getValue(); ++writeRequests; };
+
+            // Act
+            deviceUnderTest = board.ConnectHost();
+            deviceUnderTest.pinMode(outputPin, PinMode.OUTPUT);
+
+            board.HostStream.Disconnect();
+
+            deviceUnderTest.digitalWrite(outputPin, PinState.HIGH);
+            deviceUnderTest.pinMode(inputPin, PinMode.INPUT);
+
+            // Nothing may reach the board while the link is down
+            await Task.Delay(100);
+            int writeRequestsWhileDisconnected = writeRequests;
+            var inputModeWhileDisconnected = board.Board.Pins[inputPin].CurrentMode;
+
+            board.HostStream.Reconnect();
+
+            // Wait for the board to recieve the replayed state
+            await Task.Delay(200);
+
+            // Assert
+            Assert.AreEqual(0, writeRequestsWhileDisconnected, "A write was sent while the link was down");
+            Assert.AreNotEqual(PinMode.INPUT, inputModeWhileDisconnected, "A pin mode was sent while the link was down");
+            Assert.AreEqual(1, writeRequests, "The shadowed port should be replayed exactly once");
+            Assert.AreEqual(0x01, writtenPortValue, "The replayed port value was incorrect");
+            Assert.AreEqual(PinMode.INPUT, board.Board.Pins[inputPin].CurrentMode, "The shadowed pin mode was not replayed");
+            Assert.AreEqual(PinState.HIGH, deviceUnderTest.digitalRead(outputPin), "The cached output state was lost");
+        }
+    }
+}
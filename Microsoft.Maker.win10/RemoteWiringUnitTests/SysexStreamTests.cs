@@ -0,0 +1,116 @@
+﻿using Microsoft.Maker.Firmata;
+using Microsoft.VisualStudio.TestPlatform.UnitTestFramework;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Windows.Storage.Streams;
+
+namespace RemoteWiringUnitTests
+{
+    /// <summary>
+    /// Records every call made to a stream handler, in the order they were made
+    /// </summary>
+    class RecordingStreamHandler : ISysexStreamHandler
+    {
+        public List<string> Calls = new List<string>();
+        public List<byte> Payload = new List<byte>();
+        public List<uint> ChunkLengths = new List<uint>();
+        public ManualResetEventSlim Finished = new ManualResetEventSlim();
+
+        public void begin(byte command_)
+        {
+            lock (this.Calls)
+            {
+                this.Calls.Add("begin " + command_);
+            }
+        }
+
+        public void chunk(IBuffer buffer_)
+        {
+            lock (this.Calls)
+            {
+                this.Calls.Add("chunk");
+                this.ChunkLengths.Add(buffer_.Length);
+
+                var bytes = new byte[buffer_.Length];
+                DataReader.FromBuffer(buffer_).ReadBytes(bytes);
+                this.Payload.AddRange(bytes);
+            }
+        }
+
+        public void end()
+        {
+            lock (this.Calls)
+            {
+                this.Calls.Add("end");
+            }
+            this.Finished.Set();
+        }
+
+        public void abort()
+        {
+            lock (this.Calls)
+            {
+                this.Calls.Add("abort");
+            }
+            this.Finished.Set();
+        }
+    }
+
+    [TestClass]
+    public class SysexStreamTests
+    {
+        [TestMethod]
+        public void TestStreamedSysexIsDeliveredAsBeginChunksEnd()
+        {
+            // Arrange
+            const byte streamCommand = 0x01;
+            const int payloadLength = 200;
+            const uint maxChunkBytes = 64;
+
+            LoopbackStream hostStream;
+            LoopbackStream boardStream;
+            LoopbackStream.CreatePair(out hostStream, out boardStream);
+
+            var handler = new RecordingStreamHandler();
+            var analogReported = new ManualResetEventSlim();
+            bool reportedAfterEnd = false;
+
+            var firmata = new UwpFirmata();
+            firmata.setSysexStreamHandler(streamCommand, handler);
+            firmata.AnalogValueUpdated += (caller, argv) => { reportedAfterEnd = handler.Finished.IsSet; analogReported.Set(); };
+            firmata.begin(hostStream);
+            firmata.startListening();
+
+            var payload = Enumerable.Range(0, payloadLength).Select(i => (byte)(i & 0x7F)).ToArray();
+
+            // Act
+            // The streamed message is followed by an ordinary message, which must be parsed as usual once the stream has ended
+            boardStream.write((byte)Command.START_SYSEX);
+            boardStream.write(streamCommand);
+            boardStream.write(payload);
+            boardStream.write((byte)Command.END_SYSEX);
+            boardStream.write((byte)((byte)Command.ANALOG_MESSAGE | 2));
+            boardStream.write(0x10);
+            boardStream.write(0x00);
+            boardStream.flush();
+
+            // Assert
+            Assert.IsTrue(handler.Finished.Wait(2000), "The handler was never told the message had finished");
+            Assert.IsTrue(analogReported.Wait(2000), "The message following the stream was not parsed");
+
+            lock (handler.Calls)
+            {
+                Assert.AreEqual("begin " + streamCommand, handler.Calls.First(), "begin() must be the first call");
+                Assert.AreEqual("end", handler.Calls.Last(), "end() must be the last call");
+                Assert.IsTrue(handler.Calls.Skip(1).Take(handler.Calls.Count - 2).All(call => call == "chunk"), "Only chunks may be delivered between begin() and end()");
+                Assert.IsTrue(handler.ChunkLengths.All(length => length > 0 && length <= maxChunkBytes), "Each chunk must hold between 1 and 64 bytes");
+                CollectionAssert.AreEqual(payload, handler.Payload.ToArray(), "The chunks should concatenate to the payload, without the command byte");
+            }
+            Assert.IsTrue(reportedAfterEnd, "The following message must not be raised before the stream has ended");
+        }
+    }
+}
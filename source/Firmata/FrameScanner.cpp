@@ -0,0 +1,75 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "FrameScanner.h"
+
+#include <cstring>
+#include <intrin.h>
+
+#if defined( _M_IX86 ) || defined( _M_X64 )
+#include <emmintrin.h>
+#endif
+
+using namespace Microsoft::Maker::Firmata;
+
+size_t
+FrameScanner::findCommandByte(
+    const uint8_t *data_,
+    size_t length_
+    )
+{
+    size_t offset = 0;
+
+#if defined( _M_IX86 ) || defined( _M_X64 )
+    //sixteen bytes are tested at once, the mask holds the most significant bit of each so its lowest set bit is the first command byte
+    const size_t BLOCK_SIZE = 16;
+    for( ; offset + BLOCK_SIZE <= length_; offset += BLOCK_SIZE )
+    {
+        unsigned long mask = static_cast<unsigned long>( _mm_movemask_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i *>( data_ + offset ) ) ) );
+        if( mask )
+        {
+            unsigned long index;
+            _BitScanForward( &index, mask );
+            return offset + index;
+        }
+    }
+#else
+    //eight bytes are tested at once as a single word, and the block containing a command byte is searched below
+    const size_t BLOCK_SIZE = 8;
+    for( ; offset + BLOCK_SIZE <= length_; offset += BLOCK_SIZE )
+    {
+        uint64_t word;
+        memcpy( &word, data_ + offset, sizeof( word ) );
+        if( word & 0x8080808080808080ULL ) break;
+    }
+#endif
+
+    for( ; offset < length_; ++offset )
+    {
+        if( data_[offset] & 0x80 ) return offset;
+    }
+
+    return length_;
+}
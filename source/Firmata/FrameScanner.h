@@ -0,0 +1,52 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+
+/*
+ * This class finds the boundaries of Firmata messages in received data. Every command byte, including END_SYSEX, has its most
+ * significant bit set while data bytes never do, so a whole block of bytes can be tested at once and the data between command bytes
+ * copied or skipped in bulk.
+ */
+class FrameScanner
+{
+public:
+    //returns the offset of the first command byte in the given data, or length_ if every byte is a data byte
+    static
+    size_t
+    findCommandByte(
+        const uint8_t *data_,
+        size_t length_
+    );
+};
+
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
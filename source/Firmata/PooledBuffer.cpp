@@ -0,0 +1,171 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "PooledBuffer.h"
+
+using namespace Microsoft::Maker::Firmata;
+
+//******************************************************************************
+//* BufferPool
+//******************************************************************************
+
+std::shared_ptr<std::vector<uint8_t>>
+BufferPool::acquire(
+    void
+    )
+{
+    std::unique_ptr<std::vector<uint8_t>> block;
+
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _pool_mutex );
+        if( !_free_blocks.empty() )
+        {
+            block = std::move( _free_blocks.back() );
+            _free_blocks.pop_back();
+        }
+    }
+
+    if( !block )
+    {
+        block.reset( new std::vector<uint8_t>() );
+    }
+    block->clear();
+
+    //the block finds its way back to the pool when released, unless the pool has already been destroyed
+    std::weak_ptr<BufferPool> pool = shared_from_this();
+    return std::shared_ptr<std::vector<uint8_t>>( block.release(), [ pool ]( std::vector<uint8_t> *block_ ) -> void
+    {
+        std::shared_ptr<BufferPool> owner = pool.lock();
+        if( owner )
+        {
+            owner->release( block_ );
+        }
+        else
+        {
+            delete block_;
+        }
+    } );
+}
+
+void
+BufferPool::release(
+    std::vector<uint8_t> *block_
+    )
+{
+    std::unique_ptr<std::vector<uint8_t>> block( block_ );
+
+    std::lock_guard<std::mutex> lock( _pool_mutex );
+    if( _free_blocks.size() < MAX_FREE_BLOCKS )
+    {
+        _free_blocks.push_back( std::move( block ) );
+    }
+}
+
+
+//******************************************************************************
+//* PooledBuffer
+//******************************************************************************
+
+Windows::Storage::Streams::IBuffer ^
+PooledBuffer::createView(
+    std::shared_ptr<std::vector<uint8_t>> block_,
+    size_t offset_,
+    size_t length_
+    )
+{
+    Microsoft::WRL::ComPtr<PooledBuffer> buffer;
+    if( FAILED( Microsoft::WRL::MakeAndInitialize<PooledBuffer>( &buffer, block_, offset_, length_ ) ) )
+    {
+        return nullptr;
+    }
+
+    //the handle takes its own reference to the view
+    IInspectable *inspectable = reinterpret_cast<IInspectable *>( static_cast<ABI::Windows::Storage::Streams::IBuffer *>( buffer.Get() ) );
+    return reinterpret_cast<Windows::Storage::Streams::IBuffer ^>( inspectable );
+}
+
+HRESULT
+PooledBuffer::RuntimeClassInitialize(
+    std::shared_ptr<std::vector<uint8_t>> block_,
+    size_t offset_,
+    size_t length_
+    )
+{
+    if( !block_ || offset_ > block_->size() || length_ > block_->size() - offset_ )
+    {
+        return E_INVALIDARG;
+    }
+
+    _block = block_;
+    _offset = offset_;
+    _capacity = static_cast<UINT32>( length_ );
+    _length = _capacity;
+    return S_OK;
+}
+
+STDMETHODIMP
+PooledBuffer::Buffer(
+    byte **value_
+    )
+{
+    if( value_ == nullptr ) return E_POINTER;
+
+    *value_ = _block->data() + _offset;
+    return S_OK;
+}
+
+STDMETHODIMP
+PooledBuffer::get_Capacity(
+    UINT32 *value_
+    )
+{
+    if( value_ == nullptr ) return E_POINTER;
+
+    *value_ = _capacity;
+    return S_OK;
+}
+
+STDMETHODIMP
+PooledBuffer::get_Length(
+    UINT32 *value_
+    )
+{
+    if( value_ == nullptr ) return E_POINTER;
+
+    *value_ = _length;
+    return S_OK;
+}
+
+STDMETHODIMP
+PooledBuffer::put_Length(
+    UINT32 value_
+    )
+{
+    //the view can never grow beyond the range of the block it was created over
+    if( value_ > _capacity ) return E_INVALIDARG;
+
+    _length = value_;
+    return S_OK;
+}
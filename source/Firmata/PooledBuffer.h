@@ -0,0 +1,125 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <wrl.h>
+#include <robuffer.h>
+#include <windows.storage.streams.h>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+
+/*
+ * This class holds the blocks of memory which received sysex messages are parsed into. A block is returned to the pool once the
+ * last reference to it is released, including every PooledBuffer view of it, so its storage is reused rather than reallocated.
+ * Each acquire() still creates a shared_ptr control block and takes the pool lock, which is why short messages are not pooled.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool>
+{
+public:
+    //returns an empty block, which keeps the capacity it had when it was last used
+    std::shared_ptr<std::vector<uint8_t>>
+    acquire(
+        void
+    );
+
+private:
+    //blocks beyond this count are freed rather than kept for reuse
+    static const size_t MAX_FREE_BLOCKS = 16;
+
+    std::mutex _pool_mutex;
+    std::vector<std::unique_ptr<std::vector<uint8_t>>> _free_blocks;
+
+    void
+    release(
+        std::vector<uint8_t> *block_
+    );
+};
+
+/*
+ * This class is an IBuffer which is a view of part of a pooled block, exposing the memory directly through IBufferByteAccess.
+ * The view holds a reference to its block, so the memory remains valid for as long as a consumer holds the buffer.
+ */
+class PooledBuffer : public Microsoft::WRL::RuntimeClass<
+    Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::RuntimeClassType::WinRtClassicComMix>,
+    ABI::Windows::Storage::Streams::IBuffer,
+    Windows::Storage::Streams::IBufferByteAccess>
+{
+    InspectableClass( L"Microsoft.Maker.Firmata.PooledBuffer", BaseTrust )
+
+public:
+    //creates an IBuffer over the given range of the block without copying it
+    static
+    Windows::Storage::Streams::IBuffer ^
+    createView(
+        std::shared_ptr<std::vector<uint8_t>> block_,
+        size_t offset_,
+        size_t length_
+    );
+
+    HRESULT
+    RuntimeClassInitialize(
+        std::shared_ptr<std::vector<uint8_t>> block_,
+        size_t offset_,
+        size_t length_
+    );
+
+    //IBufferByteAccess
+    STDMETHODIMP
+    Buffer(
+        byte **value_
+    );
+
+    //IBuffer
+    STDMETHODIMP
+    get_Capacity(
+        UINT32 *value_
+    );
+
+    STDMETHODIMP
+    get_Length(
+        UINT32 *value_
+    );
+
+    STDMETHODIMP
+    put_Length(
+        UINT32 value_
+    );
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> _block;
+    size_t _offset;
+    UINT32 _capacity;
+    UINT32 _length;
+};
+
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
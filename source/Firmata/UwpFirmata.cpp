@@ -25,6 +25,7 @@
 
 #include "pch.h"
 #include "UwpFirmata.h"
+#include "FrameScanner.h"
 #include <chrono>
 #include <cstdlib>
 
@@ -44,13 +45,27 @@ UwpFirmata::UwpFirmata(
     void
 ) :
     _data_buffer(new uint16_t[DATA_BUFFER_SIZE]),
-    _firmata_lock(_firmutex, std::defer_lock),
+    _buffer_pool(std::make_shared<BufferPool>()),
     _firmata_stream(nullptr),
     _connection_ready(ATOMIC_VAR_INIT(false)),
     _input_thread_should_exit(ATOMIC_VAR_INIT(false)),
+    _input_idle(ATOMIC_VAR_INIT(false)),
+    _input_position(0),
+    _polling_mode(ATOMIC_VAR_INIT(false)),
+    _batch_reporting(ATOMIC_VAR_INIT(false)),
+    _device_role(ATOMIC_VAR_INIT(false)),
+    _reporting_thread_should_exit(ATOMIC_VAR_INIT(false)),
+    _sampling_interval_millis(ATOMIC_VAR_INIT(DEFAULT_SAMPLING_INTERVAL_MILLIS)),
+    _analog_reporting(ATOMIC_VAR_INIT(0)),
+    _digital_reporting(ATOMIC_VAR_INIT(0)),
+    _digital_reporting_dirty(ATOMIC_VAR_INIT(0)),
+    _bulk_write_supported(ATOMIC_VAR_INIT(true)),
     firmwareVersionMajor(0),
-    firmwareVersionMinor(0)
+    firmwareVersionMinor(0),
+    firmwareName(nullptr)
 {
+    std::fill( _analog_values.begin(), _analog_values.end(), 0 );
+    std::fill( _digital_values.begin(), _digital_values.end(), 0 );
 }
 
 
@@ -86,6 +101,9 @@ UwpFirmata::begin(
 {
     if( s_ == nullptr ) return;
 
+    //bytes staged from a previous stream must not be parsed as if they had come from this one
+    _input_buffer.clear();
+    _input_position = 0;
     _firmata_stream = s_;
 
     //lock the IStream object to guarantee its state won't change while we check if it is already connected.
@@ -93,14 +111,16 @@ UwpFirmata::begin(
 
     try
     {
+        //we always care about the connection being established, as a lost connection may be re-established later
+        _firmata_stream->ConnectionEstablished += ref new Microsoft::Maker::Serial::IStreamConnectionCallback( this, &Microsoft::Maker::Firmata::UwpFirmata::onConnectionEstablished );
+
         if( _firmata_stream->connectionReady() )
         {
             onConnectionEstablished();
         }
         else
         {
-            //we only care about these status changes if the connection is not already established
-            _firmata_stream->ConnectionEstablished += ref new Microsoft::Maker::Serial::IStreamConnectionCallback( this, &Microsoft::Maker::Firmata::UwpFirmata::onConnectionEstablished );
+            //we only care about failures if the connection is not already established
             _firmata_stream->ConnectionFailed += ref new Microsoft::Maker::Serial::IStreamConnectionCallbackWithMessage( this, &Microsoft::Maker::Firmata::UwpFirmata::onConnectionFailed );
         }
 
@@ -128,6 +148,9 @@ UwpFirmata::finish(
     void
     )
 {
+    //the reporting thread acquires the lock itself, so it must be stopped outside of the critical section
+    stopReporting();
+
     {   //critical section
         std::lock_guard<std::mutex> lock( _firmutex );
         stopThreads();
@@ -135,6 +158,8 @@ UwpFirmata::finish(
         _connection_ready = false;
         _firmata_stream = nullptr;
         _data_buffer = nullptr;
+        _input_buffer.clear();
+        _input_position = 0;
 
         if( _firmata_stream != nullptr )
         {
@@ -150,7 +175,35 @@ UwpFirmata::flush(
     void
     )
 {
-    return _firmata_stream->flush();
+    //the frame is swapped out first so it is never sent twice, even if the transport throws
+    std::vector<uint8_t> frame;
+    frame.swap( _outbound_frame );
+
+    if( !frame.empty() )
+    {
+        //the whole frame is handed to the transport at once, transports which do not implement the bulk write receive it one byte at a time
+        if( _bulk_write_supported )
+        {
+            try
+            {
+                _firmata_stream->write( Platform::ArrayReference<uint8_t>( frame.data(), static_cast<unsigned int>( frame.size() ) ) );
+            }
+            catch( Platform::NotImplementedException ^ )
+            {
+                _bulk_write_supported = false;
+            }
+        }
+
+        if( !_bulk_write_supported )
+        {
+            for( uint8_t c : frame )
+            {
+                _firmata_stream->write( c );
+            }
+        }
+    }
+
+    _firmata_stream->flush();
 }
 
 void
@@ -158,7 +211,7 @@ UwpFirmata::lock(
     void
     )
 {
-    _firmata_lock.lock();
+    _firmutex.lock();
 }
 
 void
@@ -167,10 +220,70 @@ UwpFirmata::printVersion(
     )
 {
     std::lock_guard<std::mutex> lock(_firmutex);
-    _firmata_stream->write( static_cast<uint8_t>( Command::PROTOCOL_VERSION ) );
-    _firmata_stream->write( FIRMATA_PROTOCOL_MAJOR_VERSION );
-    _firmata_stream->write( FIRMATA_PROTOCOL_MINOR_VERSION );
-    _firmata_stream->flush();
+    write( static_cast<uint8_t>( Command::PROTOCOL_VERSION ) );
+    write( FIRMATA_PROTOCOL_MAJOR_VERSION );
+    write( FIRMATA_PROTOCOL_MINOR_VERSION );
+    flush();
+}
+
+uint32_t
+UwpFirmata::poll(
+    uint32_t timeout_millis_
+    )
+{
+    const std::chrono::milliseconds IDLE_SLEEP( 1 );
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds( timeout_millis_ );
+    uint32_t processed = 0;
+
+    //the input thread owns the transport unless polling mode is enabled
+    if( !_polling_mode || _firmata_stream == nullptr ) return processed;
+
+    for( ;; )
+    {
+        try
+        {
+            processInput();
+        }
+        catch( Platform::Exception ^e )
+        {
+            OutputDebugString( e->Message->Begin() );
+        }
+
+        if( !_input_idle )
+        {
+            //the deadline is checked after every message, as a device which streams without pause never leaves the transport idle
+            if( ++processed >= MAX_POLL_MESSAGES || std::chrono::steady_clock::now() >= deadline ) break;
+            continue;
+        }
+
+        //the transport has been drained, or nothing arrived before the deadline
+        auto now = std::chrono::steady_clock::now();
+        if( processed || now >= deadline ) break;
+
+        //a sleep may last a whole timer tick, so it is only used once the spin phase is over and it cannot overrun the deadline
+        if( now - start >= std::chrono::milliseconds( IDLE_SPIN_MILLIS ) && deadline - now > std::chrono::milliseconds( TIMER_TICK_MILLIS ) )
+        {
+            std::this_thread::sleep_for( IDLE_SLEEP );
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    //reports collected before a limit was reached are delivered now rather than on the next call
+    if( !_report_batch.empty() ) dispatchReportBatch();
+
+    return processed;
+}
+
+bool
+UwpFirmata::pollingMode(
+    void
+    )
+{
+    return _polling_mode;
 }
 
 void
@@ -181,18 +294,18 @@ UwpFirmata::printFirmwareVersion(
     std::lock_guard<std::mutex> lock(_firmutex);
     if( firmwareName )
     {
-        _firmata_stream->write( static_cast<uint8_t>( Command::START_SYSEX ) );
-        _firmata_stream->write( static_cast<uint8_t>( SysexCommand::REPORT_FIRMWARE ) );
-        _firmata_stream->write( firmwareVersionMajor );
-        _firmata_stream->write( firmwareVersionMinor );
+        write( static_cast<uint8_t>( Command::START_SYSEX ) );
+        write( static_cast<uint8_t>( SysexCommand::REPORT_FIRMWARE ) );
+        write( firmwareVersionMajor );
+        write( firmwareVersionMinor );
 
         for( size_t i = 0; i < firmwareName->length(); ++i )
         {
             sendValueAsTwo7bitBytes( firmwareName->at( i ) );
         }
 
-        _firmata_stream->write( static_cast<uint8_t>( Command::END_SYSEX ) );
-        _firmata_stream->flush();
+        write( static_cast<uint8_t>( Command::END_SYSEX ) );
+        flush();
     }
 }
 
@@ -201,8 +314,14 @@ UwpFirmata::processInput(
     void
     )
 {
-    uint16_t data = _firmata_stream->read();
-    if( data == static_cast<uint16_t>( -1 ) ) return;
+    uint16_t data = readInput();
+    _input_idle = ( data == static_cast<uint16_t>( -1 ) );
+    if( _input_idle )
+    {
+        //everything available from the transport has been decoded, so collected reports are delivered together
+        if( !_report_batch.empty() ) dispatchReportBatch();
+        return;
+    }
     
     uint8_t byte = data & 0x00FF;
     uint8_t upper_nibble = data & 0xF0;
@@ -239,7 +358,8 @@ UwpFirmata::processInput(
 
         //commands that do not require additional bytes
     case Command::SYSTEM_RESET:
-        //do nothing, as there is nothing to reset
+        //there is nothing to reset in this library, but a device role consumer may want to reset its own state
+        SystemResetRequested( this, ref new SystemResetCallbackEventArgs() );
         return;
 
     case Command::START_SYSEX:
@@ -248,13 +368,31 @@ UwpFirmata::processInput(
         break;
     }
 
+    //short messages are parsed into a local array, only sysex payloads (which outlive this call as views) are parsed into a pooled block
+    uint8_t short_message[2] = { 0, 0 };
+    std::shared_ptr<std::vector<uint8_t>> block = ( isMessageSysex ? _buffer_pool->acquire() : nullptr );
+
     //read the remaining message while keeping track of elapsed time to timeout in case of incomplete message
-    std::vector<uint8_t> message;
     size_t bytes_read = 0;
     auto timeout_start = std::chrono::high_resolution_clock::now();
     while( bytes_remaining || isMessageSysex )
     {
-        data = _firmata_stream->read();
+        //once the extended-command byte is known, the payload is copied in bulk up to the next command byte, which ends the message
+        if( isMessageSysex && bytes_read && _input_position < _input_buffer.size() )
+        {
+            const uint8_t *run = _input_buffer.data() + _input_position;
+            size_t run_length = FrameScanner::findCommandByte( run, _input_buffer.size() - _input_position );
+            if( run_length )
+            {
+                block->insert( block->end(), run, run + run_length );
+                _input_position += run_length;
+                bytes_read += run_length;
+                timeout_start = std::chrono::high_resolution_clock::now();
+                continue;
+            }
+        }
+
+        data = readInput();
 
         //if no data was available, check for timeout
         if( data == static_cast<uint16_t>( -1 ) )
@@ -272,9 +410,27 @@ UwpFirmata::processInput(
         //if we're parsing sysex and we've just read the END_SYSEX command, we're done.
         if( isMessageSysex && ( data == static_cast<uint16_t>( Command::END_SYSEX ) ) ) break;
 
-        message.push_back( static_cast<uint8_t>( data & 0xFF ) );
+        if( isMessageSysex ) block->push_back( static_cast<uint8_t>( data & 0xFF ) );
+        else short_message[bytes_read] = static_cast<uint8_t>( data & 0xFF );
         ++bytes_read;
         --bytes_remaining;
+
+        //a message with a streaming handler is handed over as it arrives instead of being collected here
+        if( isMessageSysex && bytes_read == 1 )
+        {
+            ISysexStreamHandler ^handler = nullptr;
+            {   //critical section
+                std::lock_guard<std::mutex> lock( _stream_handler_mutex );
+                auto registered = _stream_handlers.find( block->front() );
+                if( registered != _stream_handlers.end() ) handler = registered->second;
+            }
+
+            if( handler != nullptr )
+            {
+                streamSysex( block->front(), handler );
+                return;
+            }
+        }
     }
 
     //process the message
@@ -282,22 +438,77 @@ UwpFirmata::processInput(
     {
         //ignore these message types
     default:
-    case Command::REPORT_ANALOG_PIN:
-    case Command::REPORT_DIGITAL_PIN:
-    case Command::SET_PIN_MODE:
     case Command::END_SYSEX:
     case Command::SYSTEM_RESET:
     case Command::PROTOCOL_VERSION:
         return;
 
+    case Command::SET_PIN_MODE:
+        //set pin mode commands store the pin number in the first byte and the requested mode in the second byte
+        PinModeRequested( this, ref new CallbackEventArgs( short_message[0], short_message[1] ) );
+        break;
+
+    case Command::REPORT_ANALOG_PIN:
+        //report analog commands store the pin number in the lower nibble of the command byte, the enable flag is the only data byte
+        if( short_message[0] )
+        {
+            _analog_reporting |= ( 1 << lower_nibble );
+        }
+        else
+        {
+            _analog_reporting &= ~( 1 << lower_nibble );
+        }
+        AnalogReportingRequested( this, ref new CallbackEventArgs( lower_nibble, short_message[0] ) );
+        break;
+
+    case Command::REPORT_DIGITAL_PIN:
+        //report digital commands store the port number in the lower nibble of the command byte, the enable flag is the only data byte
+        if( short_message[0] )
+        {
+            //the current port value is always reported as soon as reporting is enabled
+            _digital_reporting |= ( 1 << lower_nibble );
+            _digital_reporting_dirty |= ( 1 << lower_nibble );
+        }
+        else
+        {
+            _digital_reporting &= ~( 1 << lower_nibble );
+        }
+        DigitalReportingRequested( this, ref new CallbackEventArgs( lower_nibble, short_message[0] ) );
+        break;
+
     case Command::ANALOG_MESSAGE:
         //report analog commands store the pin number in the lower nibble of the command byte, the value is split over two 7-bit bytes
-        AnalogValueUpdated( this, ref new CallbackEventArgs( lower_nibble, message.at( 0 ) | ( message.at( 1 ) << 7 ) ) );
+        if( _device_role )
+        {
+            //the host is writing an analog output, which is not one of the values this device reports
+            AnalogWriteRequested( this, ref new CallbackEventArgs( lower_nibble, short_message[0] | ( short_message[1] << 7 ) ) );
+        }
+        else if( _batch_reporting )
+        {
+            queueReport( ReportType::ANALOG_PIN, lower_nibble, short_message[0] | ( short_message[1] << 7 ) );
+        }
+        else
+        {
+            AnalogValueUpdated( this, ref new CallbackEventArgs( lower_nibble, short_message[0] | ( short_message[1] << 7 ) ) );
+        }
         break;
 
     case Command::DIGITAL_MESSAGE:
         //digital messages store the port number in the lower nibble of the command byte, the port value is split over two 7-bit bytes
-        DigitalPortValueUpdated( this, ref new CallbackEventArgs( lower_nibble, message.at( 0 ) | ( message.at( 1 ) << 7 ) ) );
+        if( _device_role )
+        {
+            //the host is writing the port, so the reported state follows the write
+            setDigitalPortValue( lower_nibble, static_cast<uint8_t>( short_message[0] | ( short_message[1] << 7 ) ) );
+            DigitalPortWriteRequested( this, ref new CallbackEventArgs( lower_nibble, short_message[0] | ( short_message[1] << 7 ) ) );
+        }
+        else if( _batch_reporting )
+        {
+            queueReport( ReportType::DIGITAL_PORT, lower_nibble, short_message[0] | ( short_message[1] << 7 ) );
+        }
+        else
+        {
+            DigitalPortValueUpdated( this, ref new CallbackEventArgs( lower_nibble, short_message[0] | ( short_message[1] << 7 ) ) );
+        }
         break;
 
     case Command::START_SYSEX:
@@ -305,12 +516,13 @@ UwpFirmata::processInput(
         if( bytes_read < 1 ) return;
 
         //retrieve the raw data array & extract the extended-command byte
-        uint8_t *raw_data = message.data();
+        uint8_t *raw_data = block->data();
         SysexCommand sysCommand = static_cast<SysexCommand>( raw_data[0] );
         ++raw_data;
         --bytes_read;
 
-        DataWriter ^writer = ref new DataWriter();
+        //payloads are handed to consumers as views of the block they were parsed into, offset past the extended-command byte
+        const size_t PAYLOAD_OFFSET = 1;
         switch( sysCommand )
         {
         case SysexCommand::STRING_DATA:
@@ -324,12 +536,8 @@ UwpFirmata::processInput(
 
         case SysexCommand::CAPABILITY_RESPONSE:
 
-            //Firmata does not handle capability responses in the typical way (separating bytes), so we write them directly to the DataWriter
-            for( size_t i = 0; i < bytes_read; ++i )
-            {
-                writer->WriteByte( raw_data[i] );
-            }
-            PinCapabilityResponseReceived( this, ref new SysexCallbackEventArgs( static_cast<uint8_t>( sysCommand ), writer->DetachBuffer() ) );
+            //Firmata does not handle capability responses in the typical way (separating bytes), so they are passed on directly
+            PinCapabilityResponseReceived( this, ref new SysexCallbackEventArgs( static_cast<uint8_t>( sysCommand ), PooledBuffer::createView( block, PAYLOAD_OFFSET, bytes_read ) ) );
 
             break;
 
@@ -339,30 +547,23 @@ UwpFirmata::processInput(
             reassembleByteString( raw_data, bytes_read );
 
             //if we're receiving an I2C reply, the first two bytes in our reply are the address and register
-            for( size_t i = 2; i < bytes_read / 2; ++i )
-            {
-                writer->WriteByte( raw_data[i] );
-            }
+            if( bytes_read / 2 < 2 ) break;
 
-            I2cReplyReceived( this, ref new I2cCallbackEventArgs( raw_data[0], raw_data[1], writer->DetachBuffer() ) );
+            I2cReplyReceived( this, ref new I2cCallbackEventArgs( raw_data[0], raw_data[1], PooledBuffer::createView( block, PAYLOAD_OFFSET + 2, ( bytes_read / 2 ) - 2 ) ) );
             break;
 
         default:
 
-            //we pass the data forward as-is for any other type of sysex command
-            for( size_t i = 0; i < bytes_read; ++i )
-            {
-                writer->WriteByte( raw_data[i] );
-            }
+            //queries from a host are answered directly while acting in the device role
+            if( _device_role && onDeviceRoleSysex( sysCommand, raw_data, bytes_read ) ) break;
 
-            SysexMessageReceived( this, ref new SysexCallbackEventArgs( static_cast<uint8_t>( sysCommand ), writer->DetachBuffer() ) );
+            //we pass the data forward as-is for any other type of sysex command
+            SysexMessageReceived( this, ref new SysexCallbackEventArgs( static_cast<uint8_t>( sysCommand ), PooledBuffer::createView( block, PAYLOAD_OFFSET, bytes_read ) ) );
 
         }
 
         break;
     }
-
-    //this library does not support digital write, but we need to consume the rest of the message
 }
 
 void
@@ -372,10 +573,10 @@ UwpFirmata::sendAnalog(
     )
 {
     std::lock_guard<std::mutex> lock(_firmutex);
-    _firmata_stream->write( static_cast<uint8_t>( Command::ANALOG_MESSAGE ) | ( pin_ & 0x0F ) );
-    _firmata_stream->write( static_cast<uint8_t>( value_ & 0x007F ) );
-    _firmata_stream->write( static_cast<uint8_t>( ( value_ >> 7 ) & 0x007F ) );
-    _firmata_stream->flush();
+    write( static_cast<uint8_t>( Command::ANALOG_MESSAGE ) | ( pin_ & 0x0F ) );
+    write( static_cast<uint8_t>( value_ & 0x007F ) );
+    write( static_cast<uint8_t>( ( value_ >> 7 ) & 0x007F ) );
+    flush();
 }
 
 
@@ -386,13 +587,46 @@ UwpFirmata::sendDigitalPort(
     )
 {
     std::lock_guard<std::mutex> lock(_firmutex);
-    _firmata_stream->write( static_cast<uint8_t>( Command::DIGITAL_MESSAGE ) | ( port_number_ & 0x0F ) );
-    _firmata_stream->write( port_data_ & 0x007F );
-    _firmata_stream->write( port_data_ >> 7 );
-    _firmata_stream->flush();
+    write( static_cast<uint8_t>( Command::DIGITAL_MESSAGE ) | ( port_number_ & 0x0F ) );
+    write( port_data_ & 0x007F );
+    write( port_data_ >> 7 );
+    flush();
 }
 
 
+void
+UwpFirmata::setAnalogValue(
+    uint8_t pin_,
+    uint16_t value_
+    )
+{
+    if( pin_ >= MAX_ANALOG_PINS ) return;
+    _analog_values[pin_] = value_ & 0x3FFF;
+}
+
+void
+UwpFirmata::setDigitalPortValue(
+    uint8_t port_number_,
+    uint8_t port_data_
+    )
+{
+    if( port_number_ >= MAX_PORTS ) return;
+
+    //digital ports are only reported when their value changes
+    if( _digital_values[port_number_].exchange( port_data_ ) != port_data_ )
+    {
+        _digital_reporting_dirty |= ( 1 << port_number_ );
+    }
+}
+
+void
+UwpFirmata::setSamplingInterval(
+    uint16_t interval_millis_
+    )
+{
+    _sampling_interval_millis = ( interval_millis_ < MIN_SAMPLING_INTERVAL_MILLIS ) ? MIN_SAMPLING_INTERVAL_MILLIS : interval_millis_;
+}
+
 void
 UwpFirmata::sendString(
     String ^string_
@@ -414,15 +648,16 @@ UwpFirmata::sendString(
     {   //critical section
         std::lock_guard<std::mutex> lock( _firmutex );
 
-        _firmata_stream->write( static_cast<uint8_t>( Command::START_SYSEX ) );
-        _firmata_stream->write( command_ & 0x7F );
+        write( static_cast<uint8_t>( Command::START_SYSEX ) );
+        write( command_ & 0x7F );
 
         for( size_t i = 0; i < stringA.length(); ++i )
         {
             sendValueAsTwo7bitBytes( stringA.at( i ) );
         }
 
-        _firmata_stream->write( static_cast<uint8_t>( Command::END_SYSEX ) );
+        write( static_cast<uint8_t>( Command::END_SYSEX ) );
+        flush();
     }
 }
 
@@ -444,16 +679,17 @@ UwpFirmata::sendSysex(
     //critical section equivalent to function scope
     std::lock_guard<std::mutex> lock( _firmutex );
 
-    _firmata_stream->write( static_cast<uint8_t>( Command::START_SYSEX ) );
-    _firmata_stream->write( command_ );
+    write( static_cast<uint8_t>( Command::START_SYSEX ) );
+    write( command_ );
 
     DataReader ^reader = DataReader::FromBuffer( buffer_ );
     while( reader->UnconsumedBufferLength )
     {
-        _firmata_stream->write( reader->ReadByte() & 0x7F );
+        write( reader->ReadByte() & 0x7F );
     }
 
-    _firmata_stream->write( static_cast<uint8_t>( Command::END_SYSEX ) );
+    write( static_cast<uint8_t>( Command::END_SYSEX ) );
+    flush();
 }
 
 void
@@ -461,8 +697,8 @@ UwpFirmata::sendValueAsTwo7bitBytes(
     uint16_t value_
     )
 {
-    _firmata_stream->write( value_ & 0x7F );
-    _firmata_stream->write( ( value_ >> 7 ) & 0x7F );
+    write( value_ & 0x7F );
+    write( ( value_ >> 7 ) & 0x7F );
 }
 
 void
@@ -487,11 +723,51 @@ UwpFirmata::setFirmwareNameAndVersion(
     }
 }
 
+void
+UwpFirmata::setBatchReporting(
+    bool enabled_
+    )
+{
+    _batch_reporting = enabled_;
+}
+
+void
+UwpFirmata::setPollingMode(
+    bool enabled_
+    )
+{
+    _polling_mode = enabled_;
+    if( enabled_ )
+    {
+        stopThreads();
+    }
+}
+
+void
+UwpFirmata::setSysexStreamHandler(
+    uint8_t command_,
+    ISysexStreamHandler ^handler_
+    )
+{
+    std::lock_guard<std::mutex> lock( _stream_handler_mutex );
+    if( handler_ == nullptr )
+    {
+        _stream_handlers.erase( command_ );
+    }
+    else
+    {
+        _stream_handlers[command_] = handler_;
+    }
+}
+
 void
 UwpFirmata::startListening(
     void
     )
 {
+    //input is processed on the caller's thread in polling mode
+    if( _polling_mode ) { return; }
+
     //is a thread currently running?
     if( _input_thread.joinable() ) { return; }
 
@@ -502,12 +778,39 @@ UwpFirmata::startListening(
     _input_thread = std::thread( [ this ]() -> void { inputThread(); } );
 }
 
+void
+UwpFirmata::startReporting(
+    void
+    )
+{
+    //is a thread currently running?
+    if( _reporting_thread.joinable() ) { return; }
+
+    //prepare communications
+    _reporting_thread_should_exit = false;
+    _device_role = true;
+
+    //initialize the new reporting thread
+    _reporting_thread = std::thread( [ this ]() -> void { reportingThread(); } );
+}
+
+void
+UwpFirmata::stopReporting(
+    void
+    )
+{
+    _device_role = false;
+    _reporting_thread_should_exit = true;
+    if( _reporting_thread.joinable() ) { _reporting_thread.join(); }
+    _reporting_thread_should_exit = false;
+}
+
 void
 UwpFirmata::unlock(
     void
     )
 {
-    _firmata_lock.unlock();
+    _firmutex.unlock();
 }
 
 void
@@ -515,7 +818,7 @@ UwpFirmata::write(
     uint8_t c_
     )
 {
-    _firmata_stream->write( c_ );
+    _outbound_frame.push_back( c_ );
 }
 
 
@@ -538,11 +841,27 @@ UwpFirmata::createStringFromMbs(
     return str;
 }
 
+void
+UwpFirmata::dispatchReportBatch(
+    void
+    )
+{
+    //the batch is swapped out first so new reports can be collected by a subscriber which processes input itself
+    std::vector<ReportRecord> batch;
+    batch.swap( _report_batch );
+
+    ReportBatchReceived( this, ref new ReportBatchEventArgs( Platform::ArrayReference<ReportRecord>( batch.data(), static_cast<unsigned int>( batch.size() ) ) ) );
+}
+
 void
 UwpFirmata::inputThread(
     void
     )
 {
+    const std::chrono::milliseconds IDLE_SLEEP( 1 );
+    std::chrono::steady_clock::time_point idle_start;
+    bool idle = false;
+
     //set state-tracking member variables and begin processing input
     while( !_input_thread_should_exit )
     {
@@ -554,9 +873,130 @@ UwpFirmata::inputThread(
         {
             OutputDebugString( e->Message->Begin() );
         }
+
+        //back off while the transport has no data, so an idle connection does not consume an entire core. Data arriving within the spin
+        //phase is picked up at once, after it the first message following a pause may wait for up to one timer tick
+        if( !_input_idle )
+        {
+            idle = false;
+            continue;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if( !idle )
+        {
+            idle = true;
+            idle_start = now;
+        }
+
+        if( now - idle_start < std::chrono::milliseconds( IDLE_SPIN_MILLIS ) )
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for( IDLE_SLEEP );
+        }
     }
 }
 
+uint16_t
+UwpFirmata::readInput(
+    void
+    )
+{
+    if( _input_position < _input_buffer.size() ) return _input_buffer[_input_position++];
+
+    //everything the transport has available is staged at once, so the parser can scan it for command bytes in bulk
+    _input_buffer.clear();
+    _input_position = 0;
+    for( int count = _firmata_stream->available(); count > 0; --count )
+    {
+        uint16_t data = _firmata_stream->read();
+        if( data == static_cast<uint16_t>( -1 ) ) break;
+        _input_buffer.push_back( static_cast<uint8_t>( data & 0xFF ) );
+    }
+
+    //a transport which does not report what it has available is read a byte at a time
+    if( _input_buffer.empty() ) return _firmata_stream->read();
+
+    return _input_buffer[_input_position++];
+}
+
+void
+UwpFirmata::streamSysex(
+    uint8_t command_,
+    ISysexStreamHandler ^handler_
+    )
+{
+    handler_->begin( command_ );
+
+    //each chunk is a pooled block of its own, which returns to the pool once the handler releases it
+    std::shared_ptr<std::vector<uint8_t>> block = _buffer_pool->acquire();
+    auto timeout_start = std::chrono::high_resolution_clock::now();
+    for( ;; )
+    {
+        //data is copied in bulk up to the next command byte or the end of the chunk
+        if( _input_position < _input_buffer.size() )
+        {
+            size_t staged = _input_buffer.size() - _input_position;
+            size_t space = STREAM_CHUNK_BYTES - block->size();
+            const uint8_t *run = _input_buffer.data() + _input_position;
+            size_t run_length = FrameScanner::findCommandByte( run, ( staged > space ) ? space : staged );
+            if( run_length )
+            {
+                block->insert( block->end(), run, run + run_length );
+                _input_position += run_length;
+                timeout_start = std::chrono::high_resolution_clock::now();
+                if( block->size() >= STREAM_CHUNK_BYTES )
+                {
+                    handler_->chunk( PooledBuffer::createView( block, 0, block->size() ) );
+                    block = _buffer_pool->acquire();
+                }
+                continue;
+            }
+        }
+
+        uint16_t data = readInput();
+
+        if( data == static_cast<uint16_t>( -1 ) )
+        {
+            //the bytes received so far are handed over while waiting for more, so processing overlaps with reception
+            if( !block->empty() )
+            {
+                handler_->chunk( PooledBuffer::createView( block, 0, block->size() ) );
+                block = _buffer_pool->acquire();
+            }
+
+            std::chrono::duration<double> elapsed_sec = std::chrono::high_resolution_clock::now() - timeout_start;
+
+            const double MILLIS_PER_SECOND = 1000.0;
+            if( ( elapsed_sec.count() * MILLIS_PER_SECOND ) > MESSAGE_TIMEOUT_MILLIS )
+            {
+                handler_->abort();
+                return;
+            }
+            continue;
+        }
+
+        timeout_start = std::chrono::high_resolution_clock::now();
+        if( data == static_cast<uint16_t>( Command::END_SYSEX ) ) break;
+
+        block->push_back( static_cast<uint8_t>( data & 0xFF ) );
+        if( block->size() >= STREAM_CHUNK_BYTES )
+        {
+            handler_->chunk( PooledBuffer::createView( block, 0, block->size() ) );
+            block = _buffer_pool->acquire();
+        }
+    }
+
+    if( !block->empty() )
+    {
+        handler_->chunk( PooledBuffer::createView( block, 0, block->size() ) );
+    }
+    handler_->end();
+}
+
 void
 UwpFirmata::onConnectionEstablished(
     void
@@ -587,6 +1027,119 @@ UwpFirmata::onConnectionLost(
     FirmataConnectionLost( message_ );
 }
 
+bool
+UwpFirmata::onDeviceRoleSysex(
+    SysexCommand command_,
+    uint8_t *data_,
+    size_t len_
+    )
+{
+    switch( command_ )
+    {
+    case SysexCommand::REPORT_FIRMWARE:
+        //an empty firmware message is a query from the host, which can only be answered if a name has been given
+        if( len_ || !firmwareName ) return false;
+        printFirmwareVersion();
+        return true;
+
+    case SysexCommand::SAMPLING_INTERVAL:
+        //the interval is split over two 7-bit bytes
+        if( len_ < 2 ) return false;
+        setSamplingInterval( data_[0] | ( data_[1] << 7 ) );
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+void
+UwpFirmata::reportingThread(
+    void
+    )
+{
+    //the maximum amount of time the thread will sleep before checking if it should exit
+    const std::chrono::milliseconds MAX_SLEEP_SLICE( 10 );
+
+    auto next_report = std::chrono::steady_clock::now();
+    while( !_reporting_thread_should_exit )
+    {
+        //digital ports are only reported if their value has changed, analog pins are reported every interval
+        uint16_t analog_reporting = _analog_reporting;
+        uint16_t digital_reports = _digital_reporting_dirty.exchange( 0 ) & _digital_reporting;
+
+        if( analog_reporting || digital_reports )
+        {
+            //all reports for this interval are written in a single critical section and sent with a single flush
+            std::lock_guard<std::mutex> lock( _firmutex );
+            try
+            {
+                if( _firmata_stream != nullptr && _connection_ready )
+                {
+                    for( uint8_t port = 0; port < MAX_PORTS; ++port )
+                    {
+                        if( !( digital_reports & ( 1 << port ) ) ) continue;
+                        uint8_t port_data = _digital_values[port];
+                        write( static_cast<uint8_t>( Command::DIGITAL_MESSAGE ) | port );
+                        write( port_data & 0x7F );
+                        write( port_data >> 7 );
+                    }
+
+                    for( uint8_t pin = 0; pin < MAX_ANALOG_PINS; ++pin )
+                    {
+                        if( !( analog_reporting & ( 1 << pin ) ) ) continue;
+                        uint16_t value = _analog_values[pin];
+                        write( static_cast<uint8_t>( Command::ANALOG_MESSAGE ) | pin );
+                        write( static_cast<uint8_t>( value & 0x7F ) );
+                        write( static_cast<uint8_t>( ( value >> 7 ) & 0x7F ) );
+                    }
+
+                    flush();
+                }
+            }
+            catch( Platform::Exception ^e )
+            {
+                OutputDebugString( e->Message->Begin() );
+            }
+        }
+
+        //schedule the next report; if we have fallen behind (e.g. a slow transport) we skip the missed intervals rather than bursting
+        auto now = std::chrono::steady_clock::now();
+        next_report += std::chrono::milliseconds( _sampling_interval_millis.load() );
+        if( next_report < now ) next_report = now;
+
+        while( !_reporting_thread_should_exit && now < next_report )
+        {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>( next_report - now );
+            std::this_thread::sleep_for( ( remaining < MAX_SLEEP_SLICE ) ? remaining : MAX_SLEEP_SLICE );
+            now = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+void
+UwpFirmata::queueReport(
+    ReportType type_,
+    uint8_t number_,
+    uint16_t value_
+    )
+{
+    ReportRecord record;
+    record.Type = type_;
+    record.Number = number_;
+    record.Value = value_;
+
+    //timestamps use the same representation as DateTime, 100ns intervals since January 1, 1601 (UTC)
+    FILETIME now;
+    GetSystemTimePreciseAsFileTime( &now );
+    record.Timestamp.UniversalTime = ( static_cast<int64_t>( now.dwHighDateTime ) << 32 ) | now.dwLowDateTime;
+
+    _report_batch.push_back( record );
+
+    //a transport which never runs dry must still deliver its reports
+    if( _report_batch.size() >= MAX_REPORT_BATCH ) dispatchReportBatch();
+}
+
 void
 UwpFirmata::reassembleByteString(
     uint8_t *byte_string_,
@@ -24,11 +24,15 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
+#include "PooledBuffer.h"
 
 using namespace Platform;
 using namespace Concurrency;
@@ -122,6 +126,35 @@ private:
     IBuffer ^_response;
 };
 
+public enum class ReportType {
+    DIGITAL_PORT = 0x00,
+    ANALOG_PIN = 0x01,
+};
+
+public value struct ReportRecord
+{
+    ReportType Type;
+    uint8_t Number;
+    uint16_t Value;
+    Windows::Foundation::DateTime Timestamp;
+};
+
+public ref class ReportBatchEventArgs sealed
+{
+public:
+    ReportBatchEventArgs(
+        const Platform::Array<ReportRecord> ^records_
+        ) :
+        _records( ref new Platform::Array<ReportRecord>( records_->Data, records_->Length ) )
+    {
+    }
+
+    inline Platform::Array<ReportRecord> ^ getRecords( void ) { return _records; }
+
+private:
+    Platform::Array<ReportRecord> ^_records;
+};
+
 public ref class SystemResetCallbackEventArgs sealed {
   public:
       SystemResetCallbackEventArgs() {}
@@ -162,6 +195,14 @@ public enum class SysexCommand {
     SCHEDULER_DATA = 0x7B,
     SYSEX_NON_REALTIME = 0x7E,
     SYSEX_REALTIME = 0x7F,
+
+    //extended commands, these are only understood by firmware which implements them
+    I2C_SCAN = 0x50,
+    KEYPAD_DATA = 0x51,
+    ANALOG_OVERSAMPLING = 0x52,
+    ANALOG_DEADBAND = 0x53,
+    PULSE_DATA = 0x54,
+    TELEMETRY = 0x55,
 };
 
 
@@ -170,9 +211,49 @@ public delegate void StringCallbackFunction(UwpFirmata ^caller, StringCallbackEv
 public delegate void SysexCallbackFunction(UwpFirmata ^caller, SysexCallbackEventArgs ^argv);
 public delegate void SystemResetCallbackFunction( UwpFirmata ^caller, SystemResetCallbackEventArgs ^argv );
 public delegate void I2cReplyCallbackFunction( UwpFirmata ^caller, I2cCallbackEventArgs ^argv );
+public delegate void ReportBatchCallbackFunction( UwpFirmata ^caller, ReportBatchEventArgs ^argv );
 public delegate void FirmataConnectionCallback();
 public delegate void FirmataConnectionCallbackWithMessage( Platform::String ^message );
 
+/*
+ * This interface receives a sysex message as it arrives rather than once it is complete. The payload is handed over in chunks of raw 7-bit
+ * bytes as they are read from the connection, so the whole message is never buffered and large transfers are processed during reception.
+ */
+public interface class ISysexStreamHandler
+{
+    ///<summary>
+    ///Called when a message with the command this handler is registered for begins
+    ///</summary>
+    void
+    begin(
+        uint8_t command_
+    );
+
+    ///<summary>
+    ///Called with the next part of the payload. The buffer remains valid for as long as the handler holds it.
+    ///</summary>
+    void
+    chunk(
+        IBuffer ^buffer_
+    );
+
+    ///<summary>
+    ///Called once the whole message has been received
+    ///</summary>
+    void
+    end(
+        void
+    );
+
+    ///<summary>
+    ///Called instead of end() if the message was cut short, in which case the chunks received so far are incomplete
+    ///</summary>
+    void
+    abort(
+        void
+    );
+};
+
 public ref class UwpFirmata sealed
 {
 public:
@@ -182,7 +263,13 @@ public:
     event SysexCallbackFunction^ SysexMessageReceived;
     event SysexCallbackFunction^ PinCapabilityResponseReceived;
     event I2cReplyCallbackFunction^ I2cReplyReceived;
+    event ReportBatchCallbackFunction^ ReportBatchReceived;
     event SystemResetCallbackFunction^ SystemResetRequested;
+    event CallbackFunction^ PinModeRequested;
+    event CallbackFunction^ AnalogReportingRequested;
+    event CallbackFunction^ DigitalReportingRequested;
+    event CallbackFunction^ DigitalPortWriteRequested;
+    event CallbackFunction^ AnalogWriteRequested;
     event FirmataConnectionCallback^ FirmataConnectionReady;
     event FirmataConnectionCallbackWithMessage^ FirmataConnectionFailed;
     event FirmataConnectionCallbackWithMessage^ FirmataConnectionLost;
@@ -231,6 +318,7 @@ public:
     ///<summary>
     ///Flushes any awaiting data from the outbound queue. This function must be called before any data
     ///is sent across an active connection
+    ///<para>The queued frame is handed to the transport with a single bulk write when the transport supports it.</para>
     ///</summary>
     void
     flush(
@@ -246,6 +334,27 @@ public:
         void
     );
 
+    ///<summary>
+    ///Processes input on the caller's thread, for use when polling mode is enabled. Waits up to the given timeout for data to arrive and then
+    ///parses and dispatches the messages the transport has available, returning the number of messages processed.
+    ///<para>Returns once the transport runs dry, the timeout has elapsed or 1024 messages have been processed, whichever is first,
+    ///so a device which streams without pause cannot hold the caller. Remaining input is processed by the next call.</para>
+    ///<para>Events are raised synchronously from within this call. A message which has only partially arrived is completed before returning.
+    ///Returns 0 without reading when polling mode is not enabled.</para>
+    ///</summary>
+    uint32_t
+    poll(
+        uint32_t timeout_millis_
+    );
+
+    ///<summary>
+    ///Returns true if input is processed by calls to poll() rather than by an internal input thread
+    ///</summary>
+    bool
+    pollingMode(
+        void
+    );
+
     ///<summary>
     ///Writes the firmware version.
     ///</summary>
@@ -289,6 +398,34 @@ public:
         uint8_t port_data_
     );
 
+    ///<summary>
+    ///Caches the analog value of the given pin when acting in the device role.
+    ///<para>The value will be sent to the host at every sampling interval while reporting is enabled for the pin.</para>
+    ///</summary>
+    void
+    setAnalogValue(
+        uint8_t pin_,
+        uint16_t value_
+    );
+
+    ///<summary>
+    ///Caches the digital value of the given port when acting in the device role.
+    ///<para>The value will be sent to the host on the next sampling interval if it has changed and reporting is enabled for the port.</para>
+    ///</summary>
+    void
+    setDigitalPortValue(
+        uint8_t port_number_,
+        uint8_t port_data_
+    );
+
+    ///<summary>
+    ///Sets the interval at which reports are generated when acting in the device role.
+    ///</summary>
+    void
+    setSamplingInterval(
+        uint16_t interval_millis_
+    );
+
     ///<summary>
     ///Sends string data using the STRING_DATA command across an active connection
     ///</summary>
@@ -347,15 +484,65 @@ public:
         uint8_t minor_
     );
 
+    ///<summary>
+    ///Enables or disables batch reporting. While enabled, digital and analog reports are not raised individually through DigitalPortValueUpdated
+    ///and AnalogValueUpdated. Instead, every report decoded from the data available in the transport is raised as a single ReportBatchReceived event.
+    ///<para>Reports already collected when batch reporting is disabled are still delivered as a batch.</para>
+    ///</summary>
+    void
+    setBatchReporting(
+        bool enabled_
+    );
+
+    ///<summary>
+    ///Enables or disables polling mode. While enabled, startListening() does not create an input thread and input is only processed
+    ///by calls to poll(), allowing this instance to be driven from an application's own event loop.
+    ///<para>Enabling polling mode stops an input thread which is already running.</para>
+    ///</summary>
+    void
+    setPollingMode(
+        bool enabled_
+    );
+
+    ///<summary>
+    ///Registers a handler which receives sysex messages with the given command as they arrive, or removes it if the handler is nullptr.
+    ///<para>Messages handled this way are not raised as a SysexMessageReceived event.</para>
+    ///</summary>
+    void
+    setSysexStreamHandler(
+        uint8_t command_,
+        ISysexStreamHandler ^handler_
+    );
+
     ///<summary>
     ///Spins up a thread which will listen for and process input.
-    ///<para>This function must be called before any inputs can be processed and corresponding events can be raised.</para>
+    ///<para>This function must be called before any inputs can be processed and corresponding events can be raised. It has no effect in polling mode.</para>
     ///</summary>
     void
     startListening(
         void
     );
 
+    ///<summary>
+    ///Places this instance in the device role and spins up a thread which will generate analog and digital reports on a schedule.
+    ///<para>While in the device role, SET_PIN_MODE, REPORT_ANALOG_PIN and REPORT_DIGITAL_PIN commands received from the host are raised
+    ///as events, firmware queries are answered and SAMPLING_INTERVAL requests are honored.</para>
+    ///<para>Digital and analog messages from the host are writes rather than reports, so they are raised as DigitalPortWriteRequested
+    ///and AnalogWriteRequested. A digital write is also applied to the cached port value, which a handler may correct with setDigitalPortValue().</para>
+    ///</summary>
+    void
+    startReporting(
+        void
+    );
+
+    ///<summary>
+    ///Stops the reporting thread and returns this instance to the host role.
+    ///</summary>
+    void
+    stopReporting(
+        void
+    );
+
     ///<summary>
     ///Unlocks this instance of the UwpFirmata object, allowing other threads or actions to use it.
     ///<para>This function must be explicitly invoked after each invocation of the lock() method, when the lock is no longer needed.</para>
@@ -366,7 +553,7 @@ public:
     );
 
     ///<summary>
-    ///Writes a single byte using an active connection
+    ///Writes a single byte to the outbound queue of an active connection. The byte will be sent with the next call to flush()
     ///</summary>
     void
     write(
@@ -377,6 +564,10 @@ public:
     const uint8_t FIRMATA_PROTOCOL_MAJOR_VERSION = 2;
     const uint8_t FIRMATA_PROTOCOL_MINOR_VERSION = 3;
     const double MESSAGE_TIMEOUT_MILLIS = 500.0;
+    static const size_t MAX_PORTS = 16;
+    static const size_t MAX_ANALOG_PINS = 16;
+    const uint16_t DEFAULT_SAMPLING_INTERVAL_MILLIS = 19;
+    const uint16_t MIN_SAMPLING_INTERVAL_MILLIS = 1;
 
     //version number and name array used with set/printFirmwareVersion
     uint8_t firmwareVersionMajor;
@@ -390,16 +581,57 @@ public:
     //member variables to hold the current input thread & communications
     Serial::IStream ^_firmata_stream;
 
+    //outbound frame, written to the transport in bulk by flush()
+    std::vector<uint8_t> _outbound_frame;
+    std::atomic_bool _bulk_write_supported;
+
+    //received messages are parsed into pooled blocks, which sysex payloads are then handed to consumers as views of
+    std::shared_ptr<BufferPool> _buffer_pool;
+
+    //streaming sysex handlers, guarded by _stream_handler_mutex. K = sysex command
+    static const size_t STREAM_CHUNK_BYTES = 64;
+    std::mutex _stream_handler_mutex;
+    std::map<uint8_t, ISysexStreamHandler ^> _stream_handlers;
+
     //stores the state of the connection
     std::atomic_bool _connection_ready;
 
-    //thread-safe mechanisms. std::unique_lock used to manage the lifecycle of std::mutex
+    //thread-safe mechanisms. lock() and unlock() operate on the mutex directly, so any number of threads may contend for it
     std::mutex _firmutex;
-    std::unique_lock<std::mutex> _firmata_lock;
 
     //input thread & behavior mechanisms
     std::thread _input_thread;
     std::atomic_bool _input_thread_should_exit;
+    std::atomic_bool _input_idle;
+    std::atomic_bool _polling_mode;
+
+    //back-off while the transport is idle. A 1ms sleep lasts until the next timer tick, up to 15.6ms at the default timer resolution,
+    //so input is polled with yields for IDLE_SPIN_MILLIS after the transport runs dry, and poll() never sleeps within a tick of its deadline
+    static const uint32_t IDLE_SPIN_MILLIS = 2;
+    static const uint32_t TIMER_TICK_MILLIS = 16;
+
+    //the most messages a single call to poll() will process
+    static const uint32_t MAX_POLL_MESSAGES = 1024;
+
+    //input staged from the transport for the parser, only accessed by the thread processing input
+    std::vector<uint8_t> _input_buffer;
+    size_t _input_position;
+
+    //reports collected while batch reporting is enabled, only accessed by the thread processing input
+    static const size_t MAX_REPORT_BATCH = 256;
+    std::atomic_bool _batch_reporting;
+    std::vector<ReportRecord> _report_batch;
+
+    //device role state & reporting thread mechanisms
+    std::thread _reporting_thread;
+    std::atomic_bool _device_role;
+    std::atomic_bool _reporting_thread_should_exit;
+    std::atomic_uint16_t _sampling_interval_millis;
+    std::atomic_uint16_t _analog_reporting;
+    std::atomic_uint16_t _digital_reporting;
+    std::atomic_uint16_t _digital_reporting_dirty;
+    std::array<std::atomic_uint16_t, MAX_ANALOG_PINS> _analog_values;
+    std::array<std::atomic_uint8_t, MAX_PORTS> _digital_values;
 
     String ^
     createStringFromMbs(
@@ -407,11 +639,35 @@ public:
         size_t len_
     );
 
+    void
+    dispatchReportBatch(
+        void
+    );
+
     void
     inputThread(
         void
     );
 
+    //returns the next received byte, or -1 if none is available
+    uint16_t
+    readInput(
+        void
+    );
+
+    void
+    streamSysex(
+        uint8_t command_,
+        ISysexStreamHandler ^handler_
+    );
+
+    void
+    queueReport(
+        ReportType type_,
+        uint8_t number_,
+        uint16_t value_
+    );
+
     void
     onConnectionEstablished(
         void
@@ -427,11 +683,23 @@ public:
         Platform::String ^message_
     );
 
+    bool
+    onDeviceRoleSysex(
+        SysexCommand command_,
+        uint8_t *data_,
+        size_t len_
+    );
+
     void
     stopThreads(
         void
     );
 
+    void
+    reportingThread(
+        void
+    );
+
     void
     reassembleByteString(
         uint8_t *byte_string_,
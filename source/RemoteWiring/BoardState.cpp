@@ -0,0 +1,78 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "BoardState.h"
+
+using namespace Microsoft::Maker::RemoteWiring;
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+BoardState::BoardState()
+{
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+void
+BoardState::clear(
+    void
+    )
+{
+    _pin_modes.clear();
+    _digital_states.clear();
+    _analog_values.clear();
+}
+
+void
+BoardState::setAnalogValue(
+    uint16_t pin_,
+    uint16_t value_
+    )
+{
+    _analog_values[pin_] = value_;
+}
+
+void
+BoardState::setDigitalState(
+    uint16_t pin_,
+    PinState state_
+    )
+{
+    _digital_states[pin_] = state_;
+}
+
+void
+BoardState::setPinMode(
+    uint16_t pin_,
+    PinMode mode_
+    )
+{
+    _pin_modes[pin_] = mode_;
+}
@@ -0,0 +1,154 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include "RemoteDevice.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+
+/*
+ * This class describes the complete desired output configuration of a device: pin modes, digital states and analog values (PWM duty or servo angle).
+ * It is given to RemoteDevice::applyState, which will send only the changes required to bring the device from its cached state to the desired state.
+ */
+public ref class BoardState sealed
+{
+public:
+    friend ref class RemoteDevice;
+    friend ref class CompositeDevice;
+
+    BoardState();
+
+    ///<summary>
+    ///Removes all pin modes and values from this desired state
+    ///</summary>
+    void
+    clear(
+        void
+        );
+
+    ///<summary>
+    ///Sets the desired analog value of the given pin. The value is a PWM duty for pins in PinMode.PWM, or an angle for pins in PinMode.SERVO.
+    ///<param name="pin_">A raw pin number which will be treated "as is" and used exactly as given.</param>
+    ///<param name="value_">The desired analog value for the given pin.</param>
+    ///</summary>
+    void
+    setAnalogValue(
+        uint16_t pin_,
+        uint16_t value_
+        );
+
+    ///<summary>
+    ///Sets the desired state of the given pin. The pin must be in PinMode.OUTPUT for the state to be applied.
+    ///<param name="pin_">A raw pin number which will be treated "as is" and used exactly as given.</param>
+    ///<param name="state_">The desired state for the given pin.</param>
+    ///</summary>
+    void
+    setDigitalState(
+        uint16_t pin_,
+        PinState state_
+        );
+
+    ///<summary>
+    ///Sets the desired mode of the given pin.
+    ///<param name="pin_">A raw pin number which will be treated "as is" and used exactly as given.</param>
+    ///<param name="mode_">The desired mode for the given pin.</param>
+    ///</summary>
+    void
+    setPinMode(
+        uint16_t pin_,
+        PinMode mode_
+        );
+
+private:
+    //for each of the following maps: K = pin number, V = desired value. Pin numbers beyond a single device are used by CompositeDevice
+    std::map<uint16_t, PinMode> _pin_modes;
+    std::map<uint16_t, PinState> _digital_states;
+    std::map<uint16_t, uint16_t> _analog_values;
+};
+
+/*
+ * This class summarizes the changes which were sent to a device by RemoteDevice::applyState, or to every member of a CompositeDevice.
+ */
+public ref class StateChangeSummary sealed
+{
+public:
+    friend ref class RemoteDevice;
+    friend ref class CompositeDevice;
+
+    property int AnalogValuesChanged
+    {
+        int get()
+        {
+            return _analog_values_changed;
+        }
+    }
+
+    property int DigitalPortsChanged
+    {
+        int get()
+        {
+            return _digital_ports_changed;
+        }
+    }
+
+    property int PinModesChanged
+    {
+        int get()
+        {
+            return _pin_modes_changed;
+        }
+    }
+
+    //the total number of Firmata messages required to apply the changes, including digital report subscriptions
+    property int MessagesSent
+    {
+        int get()
+        {
+            return _messages_sent;
+        }
+    }
+
+private:
+    StateChangeSummary() :
+        _analog_values_changed( 0 ),
+        _digital_ports_changed( 0 ),
+        _pin_modes_changed( 0 ),
+        _messages_sent( 0 )
+    {
+    }
+
+    int _analog_values_changed;
+    int _digital_ports_changed;
+    int _pin_modes_changed;
+    int _messages_sent;
+};
+
+} // namespace Wiring
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,315 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "CompositeDevice.h"
+
+using namespace Concurrency;
+using namespace Windows::Foundation;
+using namespace Windows::Foundation::Collections;
+
+using namespace Microsoft::Maker::RemoteWiring;
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+CompositeDevice::CompositeDevice(
+    IIterable<RemoteDevice ^> ^devices_
+    )
+{
+    if( devices_ == nullptr ) return;
+
+    for( RemoteDevice ^device : devices_ )
+    {
+        if( device != nullptr )
+        {
+            _members.push_back( device );
+        }
+    }
+
+    //reports from every member are merged into a single stream of composite pin updates
+    //the handlers hold a weak reference, so a report already being raised when this device is released is dropped
+    Platform::WeakReference weak_this( this );
+    for( size_t i = 0; i < _members.size(); ++i )
+    {
+        _digital_tokens.push_back( _members[i]->DigitalPinUpdated += ref new DigitalPinUpdatedCallback( [ weak_this, i ]( uint8_t pin, PinState state ) -> void
+        {
+            CompositeDevice ^device = weak_this.Resolve<CompositeDevice>();
+            if( device != nullptr ) device->onDigitalPinUpdated( i, pin, state );
+        } ) );
+        _analog_tokens.push_back( _members[i]->AnalogPinUpdated += ref new AnalogPinUpdatedCallback( [ weak_this, i ]( Platform::String ^pin, uint16_t value ) -> void
+        {
+            CompositeDevice ^device = weak_this.Resolve<CompositeDevice>();
+            if( device != nullptr ) device->onAnalogPinUpdated( i, pin, value );
+        } ) );
+    }
+}
+
+CompositeDevice::~CompositeDevice(
+    void
+    )
+{
+    for( size_t i = 0; i < _members.size(); ++i )
+    {
+        _members[i]->DigitalPinUpdated -= _digital_tokens[i];
+        _members[i]->AnalogPinUpdated -= _analog_tokens[i];
+    }
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+uint16_t
+CompositeDevice::analogRead(
+    uint16_t pin_
+    )
+{
+    size_t member;
+    uint8_t member_pin;
+    if( !findMember( pin_, &member, &member_pin ) ) return static_cast<uint16_t>( -1 );
+
+    //members read analog pins by their analog number, which counts from the analog offset of the member
+    int analog_pin = member_pin - _members[member]->DeviceHardwareProfile->AnalogOffset;
+    if( analog_pin < 0 ) return static_cast<uint16_t>( -1 );
+
+    return _members[member]->analogRead( L"A" + analog_pin.ToString() );
+}
+
+void
+CompositeDevice::analogWrite(
+    uint16_t pin_,
+    uint16_t value_
+    )
+{
+    size_t member;
+    uint8_t member_pin;
+    if( !findMember( pin_, &member, &member_pin ) ) return;
+
+    _members[member]->analogWrite( member_pin, value_ );
+}
+
+IAsyncOperation<StateChangeSummary ^> ^
+CompositeDevice::applyStateAsync(
+    BoardState ^desired_state_
+    )
+{
+    //the desired state is split by member, using the pin numbers of each member
+    std::vector<BoardState ^> member_states( _members.size(), nullptr );
+    auto state_for = [ this, &member_states ]( uint16_t pin_, uint8_t *member_pin_ ) -> BoardState ^
+    {
+        size_t member;
+        if( !findMember( pin_, &member, member_pin_ ) ) return nullptr;
+
+        if( member_states[member] == nullptr )
+        {
+            member_states[member] = ref new BoardState();
+        }
+        return member_states[member];
+    };
+
+    if( desired_state_ != nullptr )
+    {
+        uint8_t member_pin;
+        for( auto &entry : desired_state_->_pin_modes )
+        {
+            BoardState ^state = state_for( entry.first, &member_pin );
+            if( state != nullptr ) state->_pin_modes[member_pin] = entry.second;
+        }
+        for( auto &entry : desired_state_->_digital_states )
+        {
+            BoardState ^state = state_for( entry.first, &member_pin );
+            if( state != nullptr ) state->_digital_states[member_pin] = entry.second;
+        }
+        for( auto &entry : desired_state_->_analog_values )
+        {
+            BoardState ^state = state_for( entry.first, &member_pin );
+            if( state != nullptr ) state->_analog_values[member_pin] = entry.second;
+        }
+    }
+
+    //each member applies its part with its own lock and flush, so members are updated in parallel
+    std::vector<task<StateChangeSummary ^>> updates;
+    for( size_t i = 0; i < _members.size(); ++i )
+    {
+        if( member_states[i] == nullptr ) continue;
+
+        RemoteDevice ^member = _members[i];
+        BoardState ^state = member_states[i];
+        updates.push_back( create_task( [ member, state ]() -> StateChangeSummary ^ { return member->applyState( state ); } ) );
+    }
+
+    return create_async( [ updates ]() -> task<StateChangeSummary ^>
+    {
+        if( updates.empty() )
+        {
+            return task_from_result( ref new StateChangeSummary() );
+        }
+
+        return when_all( updates.begin(), updates.end() ).then( []( std::vector<StateChangeSummary ^> summaries ) -> StateChangeSummary ^
+        {
+            StateChangeSummary ^total = ref new StateChangeSummary();
+            for( StateChangeSummary ^summary : summaries )
+            {
+                total->_analog_values_changed += summary->_analog_values_changed;
+                total->_digital_ports_changed += summary->_digital_ports_changed;
+                total->_pin_modes_changed += summary->_pin_modes_changed;
+                total->_messages_sent += summary->_messages_sent;
+            }
+            return total;
+        } );
+    } );
+}
+
+PinState
+CompositeDevice::digitalRead(
+    uint16_t pin_
+    )
+{
+    size_t member;
+    uint8_t member_pin;
+    if( !findMember( pin_, &member, &member_pin ) ) return PinState::LOW;
+
+    return _members[member]->digitalRead( member_pin );
+}
+
+void
+CompositeDevice::digitalWrite(
+    uint16_t pin_,
+    PinState state_
+    )
+{
+    size_t member;
+    uint8_t member_pin;
+    if( !findMember( pin_, &member, &member_pin ) ) return;
+
+    _members[member]->digitalWrite( member_pin, state_ );
+}
+
+PinMode
+CompositeDevice::getPinMode(
+    uint16_t pin_
+    )
+{
+    size_t member;
+    uint8_t member_pin;
+    if( !findMember( pin_, &member, &member_pin ) ) return PinMode::IGNORED;
+
+    return _members[member]->getPinMode( member_pin );
+}
+
+void
+CompositeDevice::pinMode(
+    uint16_t pin_,
+    PinMode mode_
+    )
+{
+    size_t member;
+    uint8_t member_pin;
+    if( !findMember( pin_, &member, &member_pin ) ) return;
+
+    _members[member]->pinMode( member_pin, mode_ );
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+bool
+CompositeDevice::findMember(
+    uint16_t pin_,
+    size_t *member_,
+    uint8_t *member_pin_
+    )
+{
+    int offset = 0;
+    for( size_t i = 0; i < _members.size(); ++i )
+    {
+        HardwareProfile ^profile = _members[i]->DeviceHardwareProfile;
+        if( profile == nullptr ) return false;
+
+        if( pin_ < offset + profile->TotalPinCount )
+        {
+            *member_ = i;
+            *member_pin_ = static_cast<uint8_t>( pin_ - offset );
+            return true;
+        }
+        offset += profile->TotalPinCount;
+    }
+
+    return false;
+}
+
+int
+CompositeDevice::getMemberOffset(
+    size_t member_
+    )
+{
+    int offset = 0;
+    for( size_t i = 0; i < member_ && i < _members.size(); ++i )
+    {
+        HardwareProfile ^profile = _members[i]->DeviceHardwareProfile;
+        if( profile == nullptr ) return -1;
+        offset += profile->TotalPinCount;
+    }
+
+    return offset;
+}
+
+
+//******************************************************************************
+//* Callbacks
+//******************************************************************************
+
+void
+CompositeDevice::onAnalogPinUpdated(
+    size_t member_,
+    Platform::String ^pin_,
+    uint16_t value_
+    )
+{
+    int offset = getMemberOffset( member_ );
+    HardwareProfile ^profile = _members[member_]->DeviceHardwareProfile;
+    if( offset < 0 || profile == nullptr || pin_ == nullptr || pin_->Length() < 2 ) return;
+
+    //members report analog pins as "A" followed by the analog number, which counts from the analog offset of the member
+    int analog_pin = _wtoi( pin_->Data() + 1 );
+    AnalogPinUpdated( static_cast<uint16_t>( offset + profile->AnalogOffset + analog_pin ), value_ );
+}
+
+void
+CompositeDevice::onDigitalPinUpdated(
+    size_t member_,
+    uint8_t pin_,
+    PinState state_
+    )
+{
+    int offset = getMemberOffset( member_ );
+    if( offset < 0 ) return;
+
+    DigitalPinUpdated( static_cast<uint16_t>( offset + pin_ ), state_ );
+}
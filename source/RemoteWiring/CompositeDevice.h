@@ -0,0 +1,188 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "RemoteDevice.h"
+#include "BoardState.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+
+public delegate void CompositeDigitalPinUpdatedCallback( uint16_t pin, PinState state );
+public delegate void CompositeAnalogPinUpdatedCallback( uint16_t pin, uint16_t value );
+
+/*
+ * This class presents several RemoteDevice instances as a single device with one pin namespace. The pins of each member are numbered
+ * after the pins of the members before it, in the order the members were given, so the first pin of a member is the total pin count of
+ * the members before it. A pin can only be addressed once its member and every member before it have completed handshaking.
+ *
+ * Each call is routed to the member which owns the pin and is only serialized by that member, the set of members never changes.
+ */
+public ref class CompositeDevice sealed
+{
+public:
+    event CompositeDigitalPinUpdatedCallback ^ DigitalPinUpdated;
+    event CompositeAnalogPinUpdatedCallback ^ AnalogPinUpdated;
+
+    ///<summary>
+    ///Creates a composite device from the given members. Digital and analog updates from every member are raised by this device using composite pin numbers.
+    ///<param name="devices_">The members of this composite device, in the order their pins are numbered</param>
+    ///</summary>
+    CompositeDevice(
+        Windows::Foundation::Collections::IIterable<RemoteDevice ^> ^devices_
+    );
+
+    virtual ~CompositeDevice();
+
+    //the total number of composite pins which can currently be addressed, this grows as members complete handshaking
+    property int TotalPinCount
+    {
+        int get()
+        {
+            int total = 0;
+            for( RemoteDevice ^member : _members )
+            {
+                HardwareProfile ^profile = member->DeviceHardwareProfile;
+                if( profile == nullptr ) break;
+                total += profile->TotalPinCount;
+            }
+            return total;
+        }
+    }
+
+    ///<summary>
+    ///Returns the most recently-reported value for the given analog pin of its member.
+    ///<param name="pin_">A composite pin number which refers to an analog pin.</param>
+    ///</summary>
+    uint16_t
+    analogRead(
+        uint16_t pin_
+    );
+
+    ///<summary>
+    ///Sets the value of the given pin to the given analog value.
+    ///<param name="pin_">A composite pin number.</param>
+    ///<param name="value_">The analog value to write to the given pin.</param>
+    ///</summary>
+    void
+    analogWrite(
+        uint16_t pin_,
+        uint16_t value_
+    );
+
+    ///<summary>
+    ///Brings every member to its part of the given desired state, which uses composite pin numbers.
+    ///<para>The desired state is split by member and each member applies its part with a single flush. Members are updated in parallel.</para>
+    ///<param name="desired_state_">The desired output configuration of the composite device.</param>
+    ///<returns>an operation which completes with the total of the changes which were sent to every member</returns>
+    ///</summary>
+    Windows::Foundation::IAsyncOperation<StateChangeSummary ^> ^
+    applyStateAsync(
+        BoardState ^desired_state_
+    );
+
+    ///<summary>
+    ///Returns the most recently-reported value for the given digital pin of its member.
+    ///<param name="pin_">A composite pin number.</param>
+    ///</summary>
+    PinState
+    digitalRead(
+        uint16_t pin_
+    );
+
+    ///<summary>
+    ///Sets the value of the given pin to the given state.
+    ///<param name="pin_">A composite pin number.</param>
+    ///<param name="state_">The desired state for the given pin.</param>
+    ///</summary>
+    void
+    digitalWrite(
+        uint16_t pin_,
+        PinState state_
+    );
+
+    ///<summary>
+    ///Retrieves the mode of the given pin from the cache of its member.
+    ///<param name="pin_">A composite pin number.</param>
+    ///</summary>
+    PinMode
+    getPinMode(
+        uint16_t pin_
+    );
+
+    ///<summary>
+    ///Sets the given pin to the given PinMode.
+    ///<param name="pin_">A composite pin number.</param>
+    ///<param name="mode_">The desired mode for the given pin.</param>
+    ///</summary>
+    void
+    pinMode(
+        uint16_t pin_,
+        PinMode mode_
+    );
+
+private:
+    //the members of this device, which never change after construction
+    std::vector<RemoteDevice ^> _members;
+
+    //the registrations for the pin update events of each member, removed when this device is destroyed
+    std::vector<Windows::Foundation::EventRegistrationToken> _digital_tokens;
+    std::vector<Windows::Foundation::EventRegistrationToken> _analog_tokens;
+
+    //finds the index of the member which owns the given composite pin, returns false if the pin cannot currently be addressed
+    bool
+    findMember(
+        uint16_t pin_,
+        size_t *member_,
+        uint8_t *member_pin_
+    );
+
+    //returns the composite pin number of the first pin of the given member, or -1 if a member before it is not ready
+    int
+    getMemberOffset(
+        size_t member_
+    );
+
+    void
+    onAnalogPinUpdated(
+        size_t member_,
+        Platform::String ^pin_,
+        uint16_t value_
+    );
+
+    void
+    onDigitalPinUpdated(
+        size_t member_,
+        uint8_t pin_,
+        PinState state_
+    );
+};
+
+} // namespace Wiring
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,238 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "CompressedHistory.h"
+
+#include <algorithm>
+
+using namespace Microsoft::Maker::RemoteWiring;
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+CompressedHistory::CompressedHistory(
+    size_t budget_bytes_
+    ) :
+    _max_blocks( budget_bytes_ / ( BLOCK_BYTES + sizeof( Block ) ) )
+{
+    //at least the block being written is always kept
+    if( !_max_blocks ) _max_blocks = 1;
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+void
+CompressedHistory::append(
+    int64_t timestamp_,
+    uint16_t value_
+    )
+{
+    //a full block is sealed and the sample begins the next one, the oldest block is discarded once the budget is reached
+    if( _blocks.empty() || ( _blocks.back().bit_count + MAX_SAMPLE_BITS ) > ( BLOCK_BYTES * 8 ) )
+    {
+        if( _blocks.size() >= _max_blocks ) _blocks.pop_front();
+
+        Block block = { timestamp_, timestamp_, 0, value_, value_, 1, 0, std::vector<uint8_t>() };
+        block.bits.reserve( BLOCK_BYTES );
+        _blocks.push_back( std::move( block ) );
+        return;
+    }
+
+    Block &block = _blocks.back();
+
+    //the change in the sampling interval: 0, or a prefix of 10, 110, 1110 or 1111 followed by 8, 16, 24 or 64 bits
+    int64_t interval = timestamp_ - block.last_timestamp;
+    uint64_t interval_change = zigzagEncode( interval - block.last_interval );
+    if( !interval_change )
+    {
+        writeBits( block, 0x0, 1 );
+    }
+    else if( interval_change < ( 1ULL << 8 ) )
+    {
+        writeBits( block, 0x2, 2 );
+        writeBits( block, interval_change, 8 );
+    }
+    else if( interval_change < ( 1ULL << 16 ) )
+    {
+        writeBits( block, 0x6, 3 );
+        writeBits( block, interval_change, 16 );
+    }
+    else if( interval_change < ( 1ULL << 24 ) )
+    {
+        writeBits( block, 0xE, 4 );
+        writeBits( block, interval_change, 24 );
+    }
+    else
+    {
+        writeBits( block, 0xF, 4 );
+        writeBits( block, interval_change, 64 );
+    }
+
+    //the change in value: 0, or a prefix of 10, 110 or 111 followed by 5, 9 or 17 bits
+    uint64_t value_change = zigzagEncode( static_cast<int64_t>( value_ ) - block.last_value );
+    if( !value_change )
+    {
+        writeBits( block, 0x0, 1 );
+    }
+    else if( value_change < ( 1ULL << 5 ) )
+    {
+        writeBits( block, 0x2, 2 );
+        writeBits( block, value_change, 5 );
+    }
+    else if( value_change < ( 1ULL << 9 ) )
+    {
+        writeBits( block, 0x6, 3 );
+        writeBits( block, value_change, 9 );
+    }
+    else
+    {
+        writeBits( block, 0x7, 3 );
+        writeBits( block, value_change, 17 );
+    }
+
+    block.last_interval = interval;
+    block.last_timestamp = timestamp_;
+    block.last_value = value_;
+    ++block.count;
+}
+
+std::vector<HistorySample>
+CompressedHistory::read(
+    int64_t start_,
+    int64_t end_
+    ) const
+{
+    std::vector<HistorySample> samples;
+    if( end_ <= start_ ) return samples;
+
+    auto block = std::lower_bound( _blocks.begin(), _blocks.end(), start_, []( const Block &block_, int64_t time_ ) { return block_.last_timestamp < time_; } );
+    for( ; block != _blocks.end() && block->first_timestamp < end_; ++block )
+    {
+        int64_t timestamp = block->first_timestamp;
+        int64_t interval = 0;
+        uint16_t value = block->first_value;
+        size_t position = 0;
+
+        for( uint32_t i = 0; i < block->count; ++i )
+        {
+            if( i )
+            {
+                //the prefix is the number of leading 1 bits, which selects the width of the change that follows
+                static const uint8_t INTERVAL_WIDTHS[] = { 0, 8, 16, 24, 64 };
+                size_t prefix = 0;
+                while( prefix < 4 && readBits( *block, position, 1 ) ) ++prefix;
+                interval += prefix ? zigzagDecode( readBits( *block, position, INTERVAL_WIDTHS[prefix] ) ) : 0;
+                timestamp += interval;
+
+                static const uint8_t VALUE_WIDTHS[] = { 0, 5, 9, 17 };
+                prefix = 0;
+                while( prefix < 3 && readBits( *block, position, 1 ) ) ++prefix;
+                value = static_cast<uint16_t>( value + ( prefix ? zigzagDecode( readBits( *block, position, VALUE_WIDTHS[prefix] ) ) : 0 ) );
+            }
+
+            if( timestamp >= end_ ) return samples;
+            if( timestamp < start_ ) continue;
+
+            HistorySample sample;
+            sample.Timestamp.UniversalTime = timestamp;
+            sample.Value = value;
+            samples.push_back( sample );
+        }
+    }
+
+    return samples;
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+uint64_t
+CompressedHistory::readBits(
+    const Block &block_,
+    size_t &position_,
+    uint8_t count_
+    )
+{
+    uint64_t value = 0;
+
+    //bits are taken a byte at a time, most significant first
+    while( count_ )
+    {
+        uint8_t available = static_cast<uint8_t>( 8 - ( position_ & 7 ) );
+        uint8_t take = ( count_ < available ) ? count_ : available;
+        uint8_t chunk = static_cast<uint8_t>( ( block_.bits[position_ >> 3] >> ( available - take ) ) & ( ( 1u << take ) - 1 ) );
+
+        value = ( value << take ) | chunk;
+        position_ += take;
+        count_ -= take;
+    }
+
+    return value;
+}
+
+void
+CompressedHistory::writeBits(
+    Block &block_,
+    uint64_t value_,
+    uint8_t count_
+    )
+{
+    //bits are placed a byte at a time, most significant first
+    while( count_ )
+    {
+        uint8_t available = static_cast<uint8_t>( 8 - ( block_.bit_count & 7 ) );
+        if( available == 8 ) block_.bits.push_back( 0 );
+
+        uint8_t take = ( count_ < available ) ? count_ : available;
+        uint8_t chunk = static_cast<uint8_t>( ( value_ >> ( count_ - take ) ) & ( ( 1u << take ) - 1 ) );
+
+        block_.bits.back() |= static_cast<uint8_t>( chunk << ( available - take ) );
+        block_.bit_count += take;
+        count_ -= take;
+    }
+}
+
+uint64_t
+CompressedHistory::zigzagEncode(
+    int64_t value_
+    )
+{
+    //signed changes are interleaved so small changes of either sign have few significant bits
+    return ( static_cast<uint64_t>( value_ ) << 1 ) ^ static_cast<uint64_t>( value_ >> 63 );
+}
+
+int64_t
+CompressedHistory::zigzagDecode(
+    uint64_t value_
+    )
+{
+    return static_cast<int64_t>( value_ >> 1 ) ^ -static_cast<int64_t>( value_ & 1 );
+}
@@ -0,0 +1,122 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+
+///<summary>
+///A single value reported by a pin.
+///</summary>
+public value struct HistorySample
+{
+    Windows::Foundation::DateTime Timestamp;
+    uint16_t Value;
+};
+
+/*
+ * This class keeps every sample of a single pin in compressed, fixed-size blocks. Timestamps are stored as the change in the interval between
+ * samples, which is almost always zero at a steady sampling rate, and values as the change from the previous value. Both are written with a
+ * variable number of bits, so a steady signal costs a few bits per sample rather than ten bytes. Once the memory budget is reached, the oldest
+ * block is discarded to make room for the next.
+ */
+class CompressedHistory
+{
+public:
+    CompressedHistory(
+        size_t budget_bytes_
+    );
+
+    void
+    append(
+        int64_t timestamp_,
+        uint16_t value_
+    );
+
+    //decodes every sample between the given times in order, skipping the blocks which end before the range
+    std::vector<HistorySample>
+    read(
+        int64_t start_,
+        int64_t end_
+    ) const;
+
+private:
+    static const size_t BLOCK_BYTES = 1024;
+
+    //the largest encoded sample, a 4 bit prefix with a raw 64 bit timestamp change and a 3 bit prefix with a 17 bit value change
+    static const size_t MAX_SAMPLE_BITS = 88;
+
+    struct Block
+    {
+        int64_t first_timestamp;
+        int64_t last_timestamp;
+        int64_t last_interval;
+        uint16_t first_value;
+        uint16_t last_value;
+        uint32_t count;
+        size_t bit_count;
+        std::vector<uint8_t> bits;
+    };
+
+    size_t _max_blocks;
+    std::deque<Block> _blocks;
+
+    static
+    uint64_t
+    readBits(
+        const Block &block_,
+        size_t &position_,
+        uint8_t count_
+    );
+
+    static
+    void
+    writeBits(
+        Block &block_,
+        uint64_t value_,
+        uint8_t count_
+    );
+
+    static
+    uint64_t
+    zigzagEncode(
+        int64_t value_
+    );
+
+    static
+    int64_t
+    zigzagDecode(
+        uint64_t value_
+    );
+};
+
+} // namespace Wiring
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,124 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+
+ref class RemoteDevice;
+
+/*
+ * This class holds the load reported by the device itself using the TELEMETRY extension. A device which takes longer to run its main
+ * loop, is short of memory or is overrunning its receive buffer is saturated, regardless of the state of the connection.
+ */
+public ref class DeviceTelemetry sealed
+{
+public:
+    friend ref class RemoteDevice;
+
+    ///<summary>
+    ///The time taken by the most recent iteration of the firmware's main loop
+    ///</summary>
+    property Windows::Foundation::TimeSpan LoopTime
+    {
+        Windows::Foundation::TimeSpan get()
+        {
+            return _loop_time;
+        }
+    }
+
+    ///<summary>
+    ///The largest number of bytes the firmware's sysex buffer has held
+    ///</summary>
+    property uint16_t SysexHighWaterMark
+    {
+        uint16_t get()
+        {
+            return _sysex_high_water_mark;
+        }
+    }
+
+    ///<summary>
+    ///The number of bytes of RAM free on the device
+    ///</summary>
+    property uint32_t FreeRam
+    {
+        uint32_t get()
+        {
+            return _free_ram;
+        }
+    }
+
+    ///<summary>
+    ///The number of times the device's serial receive buffer has overrun, dropping data sent to it
+    ///</summary>
+    property uint32_t RxOverruns
+    {
+        uint32_t get()
+        {
+            return _rx_overruns;
+        }
+    }
+
+    ///<summary>
+    ///The time the telemetry was received
+    ///</summary>
+    property Windows::Foundation::DateTime Timestamp
+    {
+        Windows::Foundation::DateTime get()
+        {
+            return _timestamp;
+        }
+    }
+
+private:
+    DeviceTelemetry(
+        Windows::Foundation::TimeSpan loop_time_,
+        uint16_t sysex_high_water_mark_,
+        uint32_t free_ram_,
+        uint32_t rx_overruns_,
+        Windows::Foundation::DateTime timestamp_
+        ) :
+        _loop_time( loop_time_ ),
+        _sysex_high_water_mark( sysex_high_water_mark_ ),
+        _free_ram( free_ram_ ),
+        _rx_overruns( rx_overruns_ ),
+        _timestamp( timestamp_ )
+    {
+    }
+
+    Windows::Foundation::TimeSpan _loop_time;
+    uint16_t _sysex_high_water_mark;
+    uint32_t _free_ram;
+    uint32_t _rx_overruns;
+    Windows::Foundation::DateTime _timestamp;
+};
+
+} // namespace Wiring
+} // namespace Maker
+} // namespace Microsoft
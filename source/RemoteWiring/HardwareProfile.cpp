@@ -103,6 +103,20 @@ HardwareProfile::~HardwareProfile()
 //* Public Methods
 //******************************************************************************
 
+uint8_t
+HardwareProfile::getAnalogResolution(
+    size_t pin_
+    )
+{
+    if( !isAnalogSupported( pin_ ) || _analogResolutions == nullptr )
+    {
+        return 0;
+    }
+
+    auto it = _analogResolutions->find( static_cast<uint8_t>( pin_ ) );
+    return ( it == _analogResolutions->end() ) ? 0 : it->second;
+}
+
 uint8_t
 HardwareProfile::getPinCapabilitiesBitmask(
     size_t pin_
@@ -381,3 +395,22 @@ HardwareProfile::initializeWithFirmata(
     _servoResolutions = servoResolutions;
     _is_valid = true;
 }
+
+void
+HardwareProfile::setAnalogResolution(
+    size_t pin_,
+    uint8_t resolution_
+    )
+{
+    if( !isAnalogSupported( pin_ ) || _analogResolutions == nullptr )
+    {
+        return;
+    }
+
+    //only existing entries are updated, so the map is never restructured while it may be read
+    auto it = _analogResolutions->find( static_cast<uint8_t>( pin_ ) );
+    if( it != _analogResolutions->end() )
+    {
+        it->second = resolution_;
+    }
+}
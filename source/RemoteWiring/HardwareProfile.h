@@ -28,6 +28,8 @@ namespace Microsoft {
 namespace Maker {
 namespace RemoteWiring {
 
+ref class RemoteDevice;
+
 /*
  * Protocol enum is used to recognize which protocol the initialization data represents.
  * Currently, the only option is Firmata, which is the only protocol Remote Arduino currently supports
@@ -59,6 +61,7 @@ public ref class HardwareProfile sealed
 {
 
 public:
+    friend ref class RemoteDevice;
 
     //this is a required property which must always be accurate
     property int AnalogPinCount
@@ -246,6 +249,17 @@ public:
 
     virtual ~HardwareProfile();
 
+    ///<summary>
+    ///returns the resolution of the analog values reported for the given pin number
+    ///<para>The resolution reported by the device is updated if oversampling changes the resolution of the pin.</para>
+    ///<param name="pin_">The requested pin</param>
+    ///<returns>the resolution in bits, or 0 if the pin does not support the analog capability or this hardware profile is not valid</returns>
+    ///</summary>
+    uint8_t
+    getAnalogResolution(
+        size_t pin_
+        );
+
     ///<summary>
     ///returns the raw capabilities bitmask for the given pin, which represents all of the functionality of the pin
     ///an AND operation (&) can be performed with this bitmask and a PinCapability to determine if the given pin has the chosen capability.
@@ -344,6 +358,13 @@ private:
     initializeWithFirmata(
         Windows::Storage::Streams::IBuffer ^buffer_
         );
+
+    //updates the resolution of a pin which already supports the analog capability
+    void
+    setAnalogResolution(
+        size_t pin_,
+        uint8_t resolution_
+        );
 };
 
 } // namespace Wiring
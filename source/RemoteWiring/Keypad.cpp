@@ -0,0 +1,157 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "Keypad.h"
+
+using namespace Microsoft::Maker::Firmata;
+using namespace Microsoft::Maker::RemoteWiring::Keypad;
+
+void
+KeypadMatrix::begin(
+    const Platform::Array<uint8_t> ^row_pins_,
+    const Platform::Array<uint8_t> ^column_pins_,
+    uint16_t debounce_millis_
+    )
+{
+    if( row_pins_ == nullptr || column_pins_ == nullptr ) return;
+    if( !row_pins_->Length || row_pins_->Length > MAX_ROWS || !column_pins_->Length || column_pins_->Length > MAX_COLUMNS ) return;
+
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _keypad_mutex );
+        _row_pins.assign( row_pins_->Data, row_pins_->Data + row_pins_->Length );
+        _column_pins.assign( column_pins_->Data, column_pins_->Data + column_pins_->Length );
+        _debounce_millis = ( debounce_millis_ > MAX_DEBOUNCE_MILLIS ) ? MAX_DEBOUNCE_MILLIS : debounce_millis_;
+    }
+
+    sendConfiguration();
+}
+
+void
+KeypadMatrix::end(
+    void
+    )
+{
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _keypad_mutex );
+        _row_pins.clear();
+        _column_pins.clear();
+        _debounce_millis = 0;
+    }
+
+    //a configuration with no rows or columns stops the scan
+    sendConfiguration();
+}
+
+bool
+KeypadMatrix::isKeyDown(
+    uint8_t row_,
+    uint8_t column_
+    )
+{
+    if( row_ >= MAX_ROWS || column_ >= MAX_COLUMNS ) return false;
+
+    std::lock_guard<std::mutex> lock( _keypad_mutex );
+    return _keys_down.test( ( row_ * MAX_COLUMNS ) + column_ );
+}
+
+void
+KeypadMatrix::sendConfiguration(
+    void
+    )
+{
+    std::vector<uint8_t> row_pins;
+    std::vector<uint8_t> column_pins;
+    uint16_t debounce_millis;
+
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _keypad_mutex );
+        row_pins = _row_pins;
+        column_pins = _column_pins;
+        debounce_millis = _debounce_millis;
+
+        //the device restarts its scan with every key released
+        _keys_down.reset();
+    }
+
+    //the configuration is kept and sent again by RemoteDevice once the connection is restored
+    if( !_firmata->connectionReady() ) return;
+
+    _firmata->lock();
+    try
+    {
+        _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
+        _firmata->write( static_cast<uint8_t>( SysexCommand::KEYPAD_DATA ) );
+        _firmata->write( KEYPAD_CONFIG );
+        _firmata->write( static_cast<uint8_t>( row_pins.size() ) );
+        _firmata->write( static_cast<uint8_t>( column_pins.size() ) );
+        for( uint8_t pin : row_pins )
+        {
+            _firmata->write( pin & 0x7F );
+        }
+        for( uint8_t pin : column_pins )
+        {
+            _firmata->write( pin & 0x7F );
+        }
+        _firmata->write( debounce_millis & 0x7F );
+        _firmata->write( ( debounce_millis >> 7 ) & 0x7F );
+        _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
+        _firmata->flush();
+    }
+    catch( ... )
+    {
+    }
+    _firmata->unlock();
+}
+
+void
+KeypadMatrix::onSysexMessage(
+    SysexCallbackEventArgs ^args
+    )
+{
+    if( args->getCommand() != static_cast<uint8_t>( SysexCommand::KEYPAD_DATA ) ) return;
+
+    Windows::Storage::Streams::DataReader ^reader = Windows::Storage::Streams::DataReader::FromBuffer( args->getDataBuffer() );
+    if( !reader->UnconsumedBufferLength || reader->ReadByte() != KEYPAD_EVENT ) return;
+
+    //an event message holds a ( key, pressed ) pair for each key which changed since the last scan, the key is encoded as ( row << 3 ) | column
+    std::vector<std::pair<uint8_t, bool>> changes;
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _keypad_mutex );
+        while( reader->UnconsumedBufferLength >= 2 )
+        {
+            uint8_t key = reader->ReadByte() & 0x3F;
+            bool pressed = reader->ReadByte() != 0;
+            if( _keys_down.test( key ) == pressed ) continue;
+
+            _keys_down.set( key, pressed );
+            changes.push_back( std::make_pair( key, pressed ) );
+        }
+    }
+
+    for( auto &change : changes )
+    {
+        KeyStateChanged( change.first / MAX_COLUMNS, change.first % MAX_COLUMNS, change.second );
+    }
+}
@@ -0,0 +1,128 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+
+ref class RemoteDevice;
+
+namespace Keypad {
+
+public delegate void KeypadKeyCallback( uint8_t row_, uint8_t column_, bool pressed_ );
+
+/*
+ * This class represents a key matrix which is scanned by the device itself using the KEYPAD_DATA extension. The device drives the rows,
+ * reads the columns and debounces each key, so only key down and key up events are sent across the connection.
+ */
+public ref class KeypadMatrix sealed
+{
+public:
+    friend ref class RemoteDevice;
+
+    event KeypadKeyCallback ^ KeyStateChanged;
+
+    ///<summary>
+    ///Begins scanning the key matrix connected to the given pins. Any previous configuration is replaced.
+    ///<para>Key changes are raised as a KeyStateChanged event. If the connection is lost, scanning is configured again once it is restored.</para>
+    ///<param name="row_pins_">The pins connected to each row of the matrix, up to 8</param>
+    ///<param name="column_pins_">The pins connected to each column of the matrix, up to 8</param>
+    ///<param name="debounce_millis_">The time a key must remain stable before its change is reported</param>
+    ///</summary>
+    void
+    begin(
+        const Platform::Array<uint8_t> ^row_pins_,
+        const Platform::Array<uint8_t> ^column_pins_,
+        uint16_t debounce_millis_
+    );
+
+    ///<summary>
+    ///Stops scanning the key matrix and releases its pins on the device.
+    ///</summary>
+    void
+    end(
+        void
+    );
+
+    ///<summary>
+    ///Returns true if the key at the given row and column was most recently reported as pressed.
+    ///</summary>
+    bool
+    isKeyDown(
+        uint8_t row_,
+        uint8_t column_
+    );
+
+private:
+    static const size_t MAX_ROWS = 8;
+    static const size_t MAX_COLUMNS = 8;
+    const uint16_t MAX_DEBOUNCE_MILLIS = 0x3FFF;
+
+    //KEYPAD_DATA subcommands
+    static const uint8_t KEYPAD_CONFIG = 0x00;
+    static const uint8_t KEYPAD_EVENT = 0x01;
+
+    //singleton pattern w/ friend class to instantiate
+    KeypadMatrix(
+        Firmata::UwpFirmata ^ firmata_
+        ) :
+        _firmata( firmata_ ),
+        _debounce_millis( 0 )
+    {
+        _firmata->SysexMessageReceived += ref new Firmata::SysexCallbackFunction( [this]( Firmata::UwpFirmata ^caller, Firmata::SysexCallbackEventArgs^ args ) -> void { onSysexMessage( args ); } );
+    }
+
+    //a reference to the UAP firmata interface
+    Firmata::UwpFirmata ^_firmata;
+
+    //matrix configuration and key state cache, guarded by _keypad_mutex. Keys are indexed as ( row * MAX_COLUMNS ) + column
+    std::mutex _keypad_mutex;
+    std::vector<uint8_t> _row_pins;
+    std::vector<uint8_t> _column_pins;
+    uint16_t _debounce_millis;
+    std::bitset<MAX_ROWS * MAX_COLUMNS> _keys_down;
+
+    //sends the current configuration, this is also used to resume scanning once a lost connection is restored
+    void
+    sendConfiguration(
+        void
+    );
+
+    void
+    onSysexMessage(
+        Firmata::SysexCallbackEventArgs ^argv
+    );
+};
+
+} // namespace Keypad
+} // namespace Wiring
+} // namespace Maker
+} // namespace Microsoft
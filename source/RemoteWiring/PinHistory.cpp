@@ -0,0 +1,154 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "PinHistory.h"
+
+#include <algorithm>
+
+using namespace Microsoft::Maker::RemoteWiring;
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+PinHistory::PinHistory(
+    size_t capacity_
+    ) :
+    _capacity( capacity_ ),
+    _levels( MAX_LEVELS, Level{ std::deque<Summary>(), false } )
+{
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+void
+PinHistory::append(
+    int64_t timestamp_,
+    uint16_t value_
+    )
+{
+    const Summary sample = { timestamp_, timestamp_, value_, 1, value_, value_ };
+
+    for( size_t i = 0; i < MAX_LEVELS; ++i )
+    {
+        std::deque<Summary> &summaries = _levels[i].summaries;
+
+        //a full summary is closed and the sample begins the next one, which keeps the summaries of every level aligned to level 0
+        if( summaries.empty() || summaries.back().count == ( 1u << i ) )
+        {
+            summaries.push_back( sample );
+            if( summaries.size() > _capacity )
+            {
+                summaries.pop_front();
+                _levels[i].truncated = true;
+            }
+        }
+        else
+        {
+            merge( summaries.back(), sample );
+        }
+    }
+}
+
+std::vector<HistorySummary>
+PinHistory::query(
+    int64_t start_,
+    int64_t end_,
+    uint32_t width_
+    ) const
+{
+    std::vector<HistorySummary> result;
+    if( !width_ || end_ <= start_ ) return result;
+
+    std::deque<Summary>::const_iterator first;
+    std::deque<Summary>::const_iterator last;
+
+    //find the finest level which still reaches the start of the range and has no more than two summaries for each bin
+    for( size_t i = 0; i < MAX_LEVELS; ++i )
+    {
+        const Level &level = _levels[i];
+        first = std::lower_bound( level.summaries.begin(), level.summaries.end(), start_, []( const Summary &summary_, int64_t time_ ) { return summary_.end < time_; } );
+        last = std::lower_bound( first, level.summaries.end(), end_, []( const Summary &summary_, int64_t time_ ) { return summary_.start < time_; } );
+
+        bool reaches_start = !level.truncated || ( !level.summaries.empty() && level.summaries.front().start <= start_ );
+        if( ( reaches_start && static_cast<size_t>( last - first ) <= 2 * static_cast<size_t>( width_ ) ) || i + 1 == MAX_LEVELS ) break;
+    }
+
+    //each summary falls into the bin containing its start, or the first bin if it began before the range
+    std::vector<Summary> bins( width_, Summary{ 0, 0, 0, 0, 0, 0 } );
+    const double span = static_cast<double>( end_ - start_ );
+    for( ; first != last; ++first )
+    {
+        int64_t offset = ( first->start > start_ ) ? ( first->start - start_ ) : 0;
+        size_t bin = static_cast<size_t>( ( offset * static_cast<double>( width_ ) ) / span );
+        if( bin >= width_ ) bin = width_ - 1;
+
+        if( !bins[bin].count )
+        {
+            bins[bin] = *first;
+        }
+        else
+        {
+            merge( bins[bin], *first );
+        }
+    }
+
+    for( const Summary &bin : bins )
+    {
+        if( !bin.count ) continue;
+
+        HistorySummary summary;
+        summary.Start.UniversalTime = bin.start;
+        summary.End.UniversalTime = bin.end;
+        summary.Minimum = bin.minimum;
+        summary.Maximum = bin.maximum;
+        summary.Mean = static_cast<double>( bin.sum ) / bin.count;
+        summary.Count = bin.count;
+        result.push_back( summary );
+    }
+
+    return result;
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+void
+PinHistory::merge(
+    Summary &into_,
+    const Summary &from_
+    )
+{
+    into_.end = from_.end;
+    into_.sum += from_.sum;
+    into_.count += from_.count;
+    if( from_.minimum < into_.minimum ) into_.minimum = from_.minimum;
+    if( from_.maximum > into_.maximum ) into_.maximum = from_.maximum;
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+
+///<summary>
+///Summarizes the values reported by a pin over a span of time.
+///</summary>
+public value struct HistorySummary
+{
+    Windows::Foundation::DateTime Start;
+    Windows::Foundation::DateTime End;
+    uint16_t Minimum;
+    uint16_t Maximum;
+    double Mean;
+    uint32_t Count;
+};
+
+/*
+ * This class keeps the history of a single pin as a pyramid of summaries. Level 0 holds every sample, and each summary of level N covers
+ * 2^N consecutive samples, so the summaries of a level are merged from those of the level below as samples arrive. Every level keeps the same
+ * number of summaries, which lets coarser levels reach further into the past, and a query is answered from the finest level which covers it
+ * with no more than two summaries per bin.
+ */
+class PinHistory
+{
+public:
+    PinHistory(
+        size_t capacity_
+    );
+
+    void
+    append(
+        int64_t timestamp_,
+        uint16_t value_
+    );
+
+    //summarizes the history between the given times into no more than the given number of equal bins, bins without samples are omitted
+    std::vector<HistorySummary>
+    query(
+        int64_t start_,
+        int64_t end_,
+        uint32_t width_
+    ) const;
+
+private:
+    static const size_t MAX_LEVELS = 24;
+
+    struct Summary
+    {
+        int64_t start;
+        int64_t end;
+        uint64_t sum;
+        uint32_t count;
+        uint16_t minimum;
+        uint16_t maximum;
+    };
+
+    struct Level
+    {
+        std::deque<Summary> summaries;
+        bool truncated;
+    };
+
+    size_t _capacity;
+    std::vector<Level> _levels;
+
+    static
+    void
+    merge(
+        Summary &into_,
+        const Summary &from_
+    );
+};
+
+} // namespace Wiring
+} // namespace Maker
+} // namespace Microsoft
@@ -24,8 +24,11 @@
 
 #include "pch.h"
 #include "RemoteDevice.h"
+#include "BoardState.h"
 
 using namespace Concurrency;
+using namespace Windows::Foundation;
+using namespace Windows::Foundation::Collections;
 
 using namespace Microsoft::Maker;
 using namespace Microsoft::Maker::Firmata;
@@ -39,9 +42,13 @@ RemoteDevice::RemoteDevice(
     Serial::IStream ^serial_connection_
     ) :
     _initialized( ATOMIC_VAR_INIT(false) ),
+    _continuous_analog_reports( ATOMIC_VAR_INIT(0) ),
     _firmata( ref new Firmata::UwpFirmata ),
     _twoWire( nullptr ),
-    _hardwareProfile( nullptr )
+    _keypad( nullptr ),
+    _hardwareProfile( nullptr ),
+    _next_pulse_id( 0 ),
+    _polled_handshake_attempts( 0 )
 {
     //subscribe to all relevant connection changes from our new Firmata object and then attach the given IStream object
     _firmata->FirmataConnectionReady += ref new Firmata::FirmataConnectionCallback( this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onConnectionReady );
@@ -54,13 +61,20 @@ RemoteDevice::RemoteDevice(
     Firmata::UwpFirmata ^firmata_
     ) :
     _initialized( ATOMIC_VAR_INIT(false) ),
+    _continuous_analog_reports( ATOMIC_VAR_INIT(0) ),
     _firmata( firmata_ ),
     _twoWire( nullptr ),
-    _hardwareProfile( nullptr )
+    _keypad( nullptr ),
+    _hardwareProfile( nullptr ),
+    _next_pulse_id( 0 ),
+    _polled_handshake_attempts( 0 )
 {
     //since the UwpFirmata object is provided, we need to lock its state & verify it is not already in a connected state
     _firmata->lock();
 
+    //we always care about the connection becoming ready, as a lost connection may be re-established later
+    _firmata->FirmataConnectionReady += ref new Microsoft::Maker::Firmata::FirmataConnectionCallback( this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onConnectionReady );
+
     if( _firmata->connectionReady() )
     {
         _firmata->FirmataConnectionLost += ref new Microsoft::Maker::Firmata::FirmataConnectionCallbackWithMessage( this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onConnectionLost );
@@ -70,7 +84,6 @@ RemoteDevice::RemoteDevice(
     }
     else
     {
-        _firmata->FirmataConnectionReady += ref new Microsoft::Maker::Firmata::FirmataConnectionCallback( this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onConnectionReady );
         _firmata->FirmataConnectionFailed += ref new Microsoft::Maker::Firmata::FirmataConnectionCallbackWithMessage( this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onConnectionFailed );
         _firmata->FirmataConnectionLost += ref new Microsoft::Maker::Firmata::FirmataConnectionCallbackWithMessage( this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onConnectionLost );
         _firmata->unlock();
@@ -81,6 +94,7 @@ RemoteDevice::~RemoteDevice(
     void
     )
 {
+    if( _telemetry_timer != nullptr ) _telemetry_timer->Cancel();
     _firmata->finish();
 }
 
@@ -122,12 +136,83 @@ RemoteDevice::analogRead(
             return val;
         }
 
+        //a single-shot read stops reporting once it completes, so reporting is resumed for the cached value to become current again
+        if( parsed_pin < MAX_ANALOG_PINS && !( _continuous_analog_reports & ( 1 << parsed_pin ) ) )
+        {
+            _continuous_analog_reports |= ( 1 << parsed_pin );
+            if( _analog_samples[parsed_pin].empty() && _firmata->connectionReady() )
+            {
+                sendAnalogReporting( 1 << parsed_pin, true );
+            }
+        }
+
         val = _analog_pins[parsed_pin];
     }
 
     return val;
 }
 
+IAsyncOperation<uint16_t> ^
+RemoteDevice::analogReadAsync(
+    Platform::String ^analog_pin_
+    )
+{
+    uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
+    task_completion_event<uint16_t> sample;
+
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        //the enable is sent before the mutex is released, so a report already in flight cannot complete the read and disable reporting after it
+        if( queueAnalogSample( parsed_pin, sample ) )
+        {
+            sendAnalogReporting( 1 << parsed_pin, true );
+        }
+    }
+
+    return create_async( [ sample ]() -> task<uint16_t> { return create_task( sample ); } );
+}
+
+IAsyncOperation<IVectorView<uint16_t> ^> ^
+RemoteDevice::analogReadAsync(
+    IIterable<Platform::String ^> ^analog_pins_
+    )
+{
+    std::vector<task<uint16_t>> samples;
+    uint16_t channels = 0;
+
+    if( analog_pins_ != nullptr )
+    {
+        //critical section, the enable is sent before the mutex is released for the same reason as a single read
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        for( Platform::String ^analog_pin : analog_pins_ )
+        {
+            uint8_t parsed_pin = parsePinFromAnalogString( analog_pin );
+            task_completion_event<uint16_t> sample;
+            if( queueAnalogSample( parsed_pin, sample ) )
+            {
+                channels |= ( 1 << parsed_pin );
+            }
+            samples.push_back( create_task( sample ) );
+        }
+
+        //reporting is enabled for every pending channel in a single flush
+        if( channels )
+        {
+            sendAnalogReporting( channels, true );
+        }
+    }
+
+    return create_async( [ samples ]() -> task<IVectorView<uint16_t> ^>
+    {
+        return when_all( samples.begin(), samples.end() ).then( []( std::vector<uint16_t> values ) -> IVectorView<uint16_t> ^
+        {
+            return ( ref new Platform::Collections::Vector<uint16_t>( std::move( values ) ) )->GetView();
+        } );
+    } );
+}
+
 void
 RemoteDevice::analogWrite(
     uint8_t pin_,
@@ -151,11 +236,139 @@ RemoteDevice::analogWrite(
 
     if( _pin_mode[pin_] == static_cast<uint8_t>( PinMode::PWM ) || _pin_mode[pin_] == static_cast<uint8_t>( PinMode::SERVO ) )
     {
+        _analog_output[pin_] = value_;
+
+        //while the connection is down, only the final value for each pin is kept and sent once the connection is restored
+        if( !_firmata->connectionReady() )
+        {
+            _shadow_analog[pin_] = value_;
+            return;
+        }
+
         _firmata->sendAnalog( pin_, value_ );
     }
 }
 
 
+StateChangeSummary ^
+RemoteDevice::applyState(
+    BoardState ^desired_state_
+    )
+{
+    StateChangeSummary ^summary = ref new StateChangeSummary();
+    if( desired_state_ == nullptr ) return summary;
+
+    //critical section equivalent to function scope
+    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+    if( !_initialized )
+    {
+        return summary;
+    }
+
+    std::bitset<MAX_PINS> mode_changes;
+    std::bitset<MAX_PORTS> subscription_changes;
+    std::bitset<MAX_PORTS> port_changes;
+    std::map<uint8_t, uint16_t> analog_changes;
+
+    //pin modes are diffed first, as they determine which of the desired values can be applied
+    for( auto &entry : desired_state_->_pin_modes )
+    {
+        if( entry.first >= MAX_PINS ) continue;
+        uint8_t pin = static_cast<uint8_t>( entry.first );
+        PinMode mode = entry.second;
+        if( _pin_mode[pin] == static_cast<uint8_t>( mode ) || !isModeSupported( pin, mode ) ) continue;
+
+        int port;
+        uint8_t port_mask;
+        getPinMap( pin, &port, &port_mask );
+
+        //subscribe to the port of input pins, and unsubscribe from it if the pin WAS input
+        if( mode == PinMode::INPUT )
+        {
+            _subscribed_ports[port] |= port_mask;
+            subscription_changes.set( port );
+        }
+        else if( _pin_mode[pin] == static_cast<uint8_t>( PinMode::INPUT ) )
+        {
+            _subscribed_ports[port] &= ~port_mask;
+            subscription_changes.set( port );
+        }
+
+        //the device sets a pin LOW when it is changed to output, and its analog output is unknown after any change
+        if( mode == PinMode::OUTPUT )
+        {
+            _digital_port[port] &= ~port_mask;
+        }
+        _analog_output[pin] = UNKNOWN_ANALOG_OUTPUT;
+
+        setContinuousAnalogReport( pin, mode );
+        _pin_mode[pin] = static_cast<uint8_t>( mode );
+        mode_changes.set( pin );
+    }
+
+    //digital states are collapsed into their ports, only ports whose value differs from the cache are sent
+    for( auto &entry : desired_state_->_digital_states )
+    {
+        if( entry.first >= MAX_PINS ) continue;
+        uint8_t pin = static_cast<uint8_t>( entry.first );
+        if( _pin_mode[pin] != static_cast<uint8_t>( PinMode::OUTPUT ) ) continue;
+
+        int port;
+        uint8_t port_mask;
+        getPinMap( pin, &port, &port_mask );
+
+        uint8_t port_val = _digital_port[port];
+        if( entry.second == PinState::HIGH )
+        {
+            port_val |= port_mask;
+        }
+        else
+        {
+            port_val &= ~port_mask;
+        }
+
+        if( port_val != _digital_port[port] )
+        {
+            _digital_port[port] = port_val;
+            port_changes.set( port );
+        }
+    }
+
+    for( auto &entry : desired_state_->_analog_values )
+    {
+        if( entry.first >= MAX_PINS ) continue;
+        uint8_t pin = static_cast<uint8_t>( entry.first );
+        if( _analog_output[pin] == entry.second ) continue;
+        if( _pin_mode[pin] != static_cast<uint8_t>( PinMode::PWM ) && _pin_mode[pin] != static_cast<uint8_t>( PinMode::SERVO ) ) continue;
+
+        _analog_output[pin] = entry.second;
+        analog_changes[pin] = entry.second;
+    }
+
+    summary->_pin_modes_changed = static_cast<int>( mode_changes.count() );
+    summary->_digital_ports_changed = static_cast<int>( port_changes.count() );
+    summary->_analog_values_changed = static_cast<int>( analog_changes.size() );
+    summary->_messages_sent = summary->_pin_modes_changed + static_cast<int>( subscription_changes.count() ) + summary->_digital_ports_changed + summary->_analog_values_changed;
+
+    //if the changes cannot be sent now, they are recorded in the shadow state and sent once the connection is restored
+    if( !summary->_messages_sent || ( _firmata->connectionReady() && sendStateChanges( mode_changes, subscription_changes, port_changes, analog_changes ) ) )
+    {
+        return summary;
+    }
+
+    _shadow_pin_modes |= mode_changes;
+    _shadow_subscriptions |= subscription_changes;
+    _shadow_ports |= port_changes;
+    for( auto &analog : analog_changes )
+    {
+        _shadow_analog[analog.first] = analog.second;
+    }
+
+    return summary;
+}
+
+
 PinState
 RemoteDevice::digitalRead(
     uint8_t pin_
@@ -232,6 +445,13 @@ RemoteDevice::digitalWrite(
             _digital_port[port] &= ~port_mask;
         }
 
+        //while the connection is down, the cached port value is sent once the connection is restored
+        if( !_firmata->connectionReady() )
+        {
+            _shadow_ports.set( port );
+            return;
+        }
+
         _firmata->sendDigitalPort( port, _digital_port[port] );
     }
 }
@@ -260,175 +480,726 @@ RemoteDevice::getPinMode(
     return getPinMode( parsed_pin + _hardwareProfile->AnalogOffset );
 }
 
-void
-RemoteDevice::pinMode(
-    uint8_t pin_,
-    PinMode mode_
+TimeSpan
+RemoteDevice::getAnalogAge(
+    Platform::String ^analog_pin_
     )
 {
-    int port;
-    uint8_t port_mask;
-    getPinMap( pin_, &port, &port_mask );
+    uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
+    TimeSpan age;
+    age.Duration = INT64_MAX;
+
+    //critical section equivalent to function scope
+    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+    if( !_initialized || parsed_pin >= MAX_ANALOG_PINS || _analog_report_time[parsed_pin] == std::chrono::steady_clock::time_point() )
+    {
+        return age;
+    }
+
+    //a deadband channel is silent while its value is unchanged, so the value remains current until the silence period runs out. This only
+    //holds once the device has confirmed the deadband and while the channel is reported continuously, not after a single-shot read stopped it
+    auto current_until = _analog_report_time[parsed_pin];
+    if( _confirmed_deadband_silence[parsed_pin] && ( _continuous_analog_reports & ( 1 << parsed_pin ) ) )
+    {
+        current_until += std::chrono::milliseconds( _confirmed_deadband_silence[parsed_pin] );
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    age.Duration = ( now > current_until ) ? std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>( now - current_until ).count() : 0;
+    return age;
+}
+
+Platform::Array<HistorySummary> ^
+RemoteDevice::getAnalogHistory(
+    Platform::String ^analog_pin_,
+    DateTime start_,
+    DateTime end_,
+    uint32_t width_
+    )
+{
+    uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
+    std::vector<HistorySummary> summaries;
 
     {   //critical section
         std::lock_guard<std::recursive_mutex> lock( _device_mutex );
 
-        //verify we're initialized properly and the requested pin mode is supported by this pin
-        if( !( _initialized && isModeSupported( pin_, mode_ ) ) )
+        auto history = _analog_history.find( parsed_pin );
+        if( history != _analog_history.end() )
         {
-            return;
+            summaries = history->second.query( start_.UniversalTime, end_.UniversalTime, width_ );
         }
+    }
 
-        _firmata->lock();
-        try
-        {
-            _firmata->write( static_cast<uint8_t>( Firmata::Command::SET_PIN_MODE ) );
-            _firmata->write( pin_ );
-            _firmata->write( static_cast<uint8_t>( mode_ ) );
+    return ref new Platform::Array<HistorySummary>( summaries.data(), static_cast<unsigned int>( summaries.size() ) );
+}
 
-            //lets subscribe to this port if we're setting it to input
-            if( mode_ == PinMode::INPUT )
-            {
-                _subscribed_ports[port] |= port_mask;
-                _firmata->write( static_cast<uint8_t>( Firmata::Command::REPORT_DIGITAL_PIN ) | ( port & 0x0F ) );
-                _firmata->write( _subscribed_ports[port] );
-            }
-            //if the selected mode is NOT input and we WERE subscribed to it, unsubscribe
-            else if( _pin_mode[pin_] == static_cast<uint8_t>( PinMode::INPUT ) )
-            {
-                //make sure we aren't subscribed to this port
-                _subscribed_ports[port] &= ~port_mask;
-                _firmata->write( static_cast<uint8_t>( Firmata::Command::REPORT_DIGITAL_PIN ) | ( port & 0x0F ) );
-                _firmata->write( _subscribed_ports[port] );
-            }
-            _firmata->flush();
-        }
-        catch( ... )
-        {
-            //something has gone wrong, any fatal errors should be evented, so we need to exit this function
-            _firmata->unlock();
-            return;
-        }
+Platform::Array<HistorySample> ^
+RemoteDevice::getAnalogSamples(
+    Platform::String ^analog_pin_,
+    DateTime start_,
+    DateTime end_
+    )
+{
+    uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
+    std::vector<HistorySample> samples;
 
-        _firmata->unlock();
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
 
-        //if the pin mode is being set to output, and it isn't already in output mode, the pin value is set to 0
-        if( mode_ == PinMode::OUTPUT && _pin_mode[pin_] != static_cast<uint8_t>( PinMode::OUTPUT ) )
+        auto history = _compressed_history.find( parsed_pin );
+        if( history != _compressed_history.end() )
         {
-            _digital_port[port] &= ~port_mask;
+            samples = history->second.read( start_.UniversalTime, end_.UniversalTime );
         }
-
-        //finally, update the cached pin mode
-        _pin_mode[pin_] = static_cast<uint8_t>( mode_ );
     }
+
+    return ref new Platform::Array<HistorySample>( samples.data(), static_cast<unsigned int>( samples.size() ) );
 }
 
-void
-RemoteDevice::pinMode(
-    Platform::String ^analog_pin_,
-    PinMode mode_
+uint8_t
+RemoteDevice::getAnalogOversampling(
+    Platform::String ^analog_pin_
     )
 {
     uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
-    if( parsed_pin == static_cast<uint8_t>( -1 ) )
+    if( !_initialized || parsed_pin >= MAX_ANALOG_PINS )
     {
-        return;
+        return 1;
     }
 
-    pinMode( parsed_pin + _hardwareProfile->AnalogOffset, mode_ );
+    return static_cast<uint8_t>( 1 << _analog_oversampling[parsed_pin] );
 }
 
-
-//******************************************************************************
-//* Callbacks
-//******************************************************************************
-
-
 void
-RemoteDevice::onDigitalReport(
-    Firmata::CallbackEventArgs ^args_
+RemoteDevice::setAnalogDeadband(
+    Platform::String ^analog_pin_,
+    uint16_t threshold_,
+    uint16_t max_silence_millis_
     )
 {
-    uint8_t port = args_->getPort();
-    uint8_t port_val = static_cast<uint8_t>( args_->getValue() );
-    uint8_t port_xor;
+    uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
+    threshold_ = ( threshold_ > MAX_DEADBAND_VALUE ) ? MAX_DEADBAND_VALUE : threshold_;
+    max_silence_millis_ = ( max_silence_millis_ > MAX_DEADBAND_VALUE ) ? MAX_DEADBAND_VALUE : max_silence_millis_;
 
     {   //critical section
         std::lock_guard<std::recursive_mutex> lock( _device_mutex );
-        //output_state will only set bits which correspond to output pins that are HIGH
-        uint8_t output_state = ~_subscribed_ports[port] & _digital_port[port];
-        port_val |= output_state;
-
-        //determine which pins have changed
-        port_xor = port_val ^ _digital_port[port];
 
-        //update the cache
-        _digital_port[port] = port_val;
-    }
+        if( !_initialized || parsed_pin >= _hardwareProfile->AnalogPinCount || parsed_pin >= MAX_ANALOG_PINS )
+        {
+            return;
+        }
 
-    //throw a pin event for each pin that has changed
-    uint8_t i = 0;
-    while( port_xor > 0 )
-    {
-        if( port_xor & 0x01 )
+        //the request is kept so it can be sent again once a lost connection is restored, reporting every interval is the device default
+        if( threshold_ )
         {
-            DigitalPinUpdated( ( port * 8 ) + i, ( ( port_val >> i ) & 0x01 ) > 0 ? PinState::HIGH : PinState::LOW );
+            _deadband_requests[parsed_pin] = std::make_pair( threshold_, max_silence_millis_ );
         }
-        port_xor >>= 1;
-        ++i;
+        else
+        {
+            _deadband_requests.erase( parsed_pin );
+        }
+
+        //the previous setting no longer applies, and the new one is not relied upon until the device confirms it
+        _confirmed_deadband_silence[parsed_pin] = 0;
     }
+
+    sendAnalogDeadband( parsed_pin, threshold_, max_silence_millis_ );
 }
 
 void
-RemoteDevice::onAnalogReport(
-    Firmata::CallbackEventArgs ^args_
+RemoteDevice::setAnalogHistory(
+    Platform::String ^analog_pin_,
+    uint32_t capacity_
     )
 {
-    uint8_t pin = args_->getPort();
-    uint16_t val = args_->getValue();
-
-    {   //critical section
-        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
-        _analog_pins[pin] = val;
+    uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
+    if( parsed_pin >= MAX_ANALOG_PINS )
+    {
+        return;
     }
 
-    //throw an event for the pin value update
-    AnalogPinUpdated( L"A" + pin.ToString(), val );
+    //critical section equivalent to function scope
+    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+    _analog_history.erase( parsed_pin );
+    if( capacity_ )
+    {
+        _analog_history.emplace( parsed_pin, PinHistory( capacity_ ) );
+    }
 }
 
 void
-RemoteDevice::onSysexMessage(
-    Firmata::SysexCallbackEventArgs ^argv_
+RemoteDevice::setCompressedAnalogHistory(
+    Platform::String ^analog_pin_,
+    uint32_t budget_bytes_
     )
 {
-    SysexMessageReceived( argv_->getCommand(), Windows::Storage::Streams::DataReader::FromBuffer( argv_->getDataBuffer() ) );
+    uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
+    if( parsed_pin >= MAX_ANALOG_PINS )
+    {
+        return;
+    }
+
+    //critical section equivalent to function scope
+    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+    _compressed_history.erase( parsed_pin );
+    if( budget_bytes_ )
+    {
+        _compressed_history.emplace( parsed_pin, CompressedHistory( budget_bytes_ ) );
+    }
 }
 
 void
-RemoteDevice::onStringMessage(
-    Firmata::StringCallbackEventArgs ^argv_
+RemoteDevice::setTelemetryInterval(
+    uint32_t interval_millis_
     )
 {
-    StringMessageReceived( argv_->getString() );
-}
+    //critical section equivalent to function scope
+    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
 
+    if( _telemetry_timer != nullptr )
+    {
+        _telemetry_timer->Cancel();
+        _telemetry_timer = nullptr;
+    }
 
-//******************************************************************************
-//* Private Methods
-//******************************************************************************
+    if( !interval_millis_ ) return;
 
-void const
-RemoteDevice::initialize(
-    HardwareProfile ^hardwareProfile_
+    TimeSpan period;
+    period.Duration = static_cast<int64_t>( interval_millis_ ) * 10000;
+
+    //cancelling the timer does not wait for a query already being sent, so the callback must not keep this device alive or outlive it
+    Platform::WeakReference weak_this( this );
+    _telemetry_timer = Windows::System::Threading::ThreadPoolTimer::CreatePeriodicTimer( ref new Windows::System::Threading::TimerElapsedHandler( [ weak_this ]( Windows::System::Threading::ThreadPoolTimer ^timer_ ) -> void
+    {
+        RemoteDevice ^device = weak_this.Resolve<RemoteDevice>();
+        if( device != nullptr ) device->sendTelemetryQuery();
+    } ), period );
+}
+
+void
+RemoteDevice::setAnalogOversampling(
+    Platform::String ^analog_pin_,
+    uint8_t sample_count_,
+    OversamplingMode mode_
     )
 {
-    {   //critical section equivalent to function scope
+    uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
+    uint8_t request;
+
+    {   //critical section
         std::lock_guard<std::recursive_mutex> lock( _device_mutex );
 
-        if( _initialized ) return;
+        if( !_initialized || parsed_pin >= _hardwareProfile->AnalogPinCount || parsed_pin >= MAX_ANALOG_PINS )
+        {
+            return;
+        }
+
+        //the sample count must be a power of two, which is sent as its shift
+        uint8_t shift = 0;
+        while( shift <= MAX_OVERSAMPLING_SHIFT && ( 1 << shift ) != sample_count_ ) ++shift;
+        if( shift > MAX_OVERSAMPLING_SHIFT )
+        {
+            return;
+        }
+
+        //the request is kept so it can be sent again once a lost connection is restored, raw reports are the device default
+        request = ( static_cast<uint8_t>( mode_ ) << 3 ) | shift;
+        if( shift )
+        {
+            _oversampling_requests[parsed_pin] = request;
+        }
+        else
+        {
+            _oversampling_requests.erase( parsed_pin );
+        }
+    }
+
+    sendAnalogOversampling( parsed_pin, request );
+}
+
+void
+RemoteDevice::pinMode(
+    uint8_t pin_,
+    PinMode mode_
+    )
+{
+    int port;
+    uint8_t port_mask;
+    getPinMap( pin_, &port, &port_mask );
+
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        //verify we're initialized properly and the requested pin mode is supported by this pin
+        if( !( _initialized && isModeSupported( pin_, mode_ ) ) )
+        {
+            return;
+        }
+
+        //lets subscribe to this port if we're setting it to input
+        bool subscription_changed = false;
+        if( mode_ == PinMode::INPUT )
+        {
+            _subscribed_ports[port] |= port_mask;
+            subscription_changed = true;
+        }
+        //if the selected mode is NOT input and we WERE subscribed to it, unsubscribe
+        else if( _pin_mode[pin_] == static_cast<uint8_t>( PinMode::INPUT ) )
+        {
+            //make sure we aren't subscribed to this port
+            _subscribed_ports[port] &= ~port_mask;
+            subscription_changed = true;
+        }
+
+        //while the connection is down, the change is recorded in the cache and sent once the connection is restored
+        if( !_firmata->connectionReady() )
+        {
+            _shadow_pin_modes.set( pin_ );
+            if( subscription_changed ) _shadow_subscriptions.set( port );
+        }
+        else
+        {
+            _firmata->lock();
+            try
+            {
+                _firmata->write( static_cast<uint8_t>( Firmata::Command::SET_PIN_MODE ) );
+                _firmata->write( pin_ );
+                _firmata->write( static_cast<uint8_t>( mode_ ) );
+
+                if( subscription_changed )
+                {
+                    _firmata->write( static_cast<uint8_t>( Firmata::Command::REPORT_DIGITAL_PIN ) | ( port & 0x0F ) );
+                    _firmata->write( _subscribed_ports[port] );
+                }
+                _firmata->flush();
+            }
+            catch( ... )
+            {
+                //something has gone wrong, any fatal errors should be evented, so we need to exit this function
+                _firmata->unlock();
+                return;
+            }
+
+            _firmata->unlock();
+        }
+
+        //if the pin mode is being set to output, and it isn't already in output mode, the pin value is set to 0
+        if( mode_ == PinMode::OUTPUT && _pin_mode[pin_] != static_cast<uint8_t>( PinMode::OUTPUT ) )
+        {
+            _digital_port[port] &= ~port_mask;
+        }
+
+        //the analog output of a pin is unknown after its mode changes
+        if( _pin_mode[pin_] != static_cast<uint8_t>( mode_ ) )
+        {
+            _analog_output[pin_] = UNKNOWN_ANALOG_OUTPUT;
+        }
+
+        setContinuousAnalogReport( pin_, mode_ );
+
+        //finally, update the cached pin mode
+        _pin_mode[pin_] = static_cast<uint8_t>( mode_ );
+    }
+}
+
+void
+RemoteDevice::pinMode(
+    Platform::String ^analog_pin_,
+    PinMode mode_
+    )
+{
+    uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
+    if( parsed_pin == static_cast<uint8_t>( -1 ) )
+    {
+        return;
+    }
+
+    pinMode( parsed_pin + _hardwareProfile->AnalogOffset, mode_ );
+}
+
+uint32_t
+RemoteDevice::poll(
+    uint32_t timeout_millis_
+    )
+{
+    uint32_t processed = _firmata->poll( timeout_millis_ );
+    bool ready = false;
+    bool failed = false;
+
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        //in polling mode the handshake is driven from here, mirroring the retries of the handshake task
+        if( _polled_handshake_attempts )
+        {
+            auto now = std::chrono::steady_clock::now();
+            if( _initialized )
+            {
+                _polled_handshake_attempts = 0;
+                ready = true;
+            }
+            else if( now >= _polled_handshake_deadline )
+            {
+                if( _polled_handshake_attempts >= HANDSHAKE_MAX_ATTEMPTS )
+                {
+                    _polled_handshake_attempts = 0;
+                    failed = true;
+                }
+                else
+                {
+                    sendCapabilityQuery();
+                    ++_polled_handshake_attempts;
+                    _polled_handshake_deadline = now + std::chrono::milliseconds( HANDSHAKE_RETRY_MILLIS );
+                }
+            }
+        }
+    }
+
+    if( ready )
+    {
+        DeviceReady();
+    }
+    else if( failed )
+    {
+        DeviceConnectionFailed( L"A device connection was established, but the device failed handshaking procedures. Verify that your device is configured with StandardFirmata. Message: Pin configuration not received." );
+    }
+
+    return processed;
+}
+
+IAsyncOperation<bool> ^
+RemoteDevice::pulseAsync(
+    uint8_t pin_,
+    PinState state_,
+    uint32_t width_micros_,
+    uint16_t count_,
+    uint32_t period_micros_
+    )
+{
+    int port;
+    uint8_t port_mask;
+    getPinMap( pin_, &port, &port_mask );
+
+    task_completion_event<bool> completion;
+    bool sent = false;
+    uint32_t id = 0;
+
+    //pulses of a train may not overlap
+    bool valid = width_micros_ && width_micros_ <= MAX_PULSE_MICROS && count_ && count_ <= MAX_PULSE_COUNT && period_micros_ <= MAX_PULSE_MICROS
+        && ( count_ == 1 || period_micros_ >= width_micros_ );
+
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        if( valid && _initialized && _firmata->connectionReady() && pin_ < MAX_PINS && _pin_mode[pin_] == static_cast<uint8_t>( PinMode::OUTPUT ) )
+        {
+            _firmata->lock();
+            try
+            {
+                _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
+                _firmata->write( static_cast<uint8_t>( SysexCommand::PULSE_DATA ) );
+                _firmata->write( pin_ );
+                _firmata->write( static_cast<uint8_t>( state_ ) );
+                for( int shift = 0; shift < 28; shift += 7 )
+                {
+                    _firmata->write( ( width_micros_ >> shift ) & 0x7F );
+                }
+                _firmata->write( count_ & 0x7F );
+                _firmata->write( ( count_ >> 7 ) & 0x7F );
+                for( int shift = 0; shift < 28; shift += 7 )
+                {
+                    _firmata->write( ( period_micros_ >> shift ) & 0x7F );
+                }
+                _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
+                _firmata->flush();
+                sent = true;
+            }
+            catch( ... )
+            {
+            }
+            _firmata->unlock();
+        }
+
+        if( sent )
+        {
+            id = _next_pulse_id++;
+            PendingPulse pulse = { id, completion };
+            _pending_pulses[pin_].push_back( pulse );
+
+            //the pin rests at the opposite state once the pulse train has completed
+            if( static_cast<uint8_t>( state_ ) )
+            {
+                _digital_port[port] &= ~port_mask;
+            }
+            else
+            {
+                _digital_port[port] |= port_mask;
+            }
+        }
+    }
+
+    if( !sent )
+    {
+        completion.set( false );
+    }
+    else
+    {
+        //firmware which does not implement the extension ignores the request, so the train fails once it should long have completed
+        Platform::WeakReference weak_this( this );
+        TimeSpan timeout;
+        timeout.Duration = ( static_cast<int64_t>( width_micros_ ) + static_cast<int64_t>( count_ - 1 ) * period_micros_ ) * 10 + PULSE_TIMEOUT_MARGIN_MILLIS * 10000;
+        Windows::System::Threading::ThreadPoolTimer::CreateTimer( ref new Windows::System::Threading::TimerElapsedHandler( [ weak_this, pin_, id, completion ]( Windows::System::Threading::ThreadPoolTimer ^timer_ ) -> void
+        {
+            RemoteDevice ^device = weak_this.Resolve<RemoteDevice>();
+            if( device != nullptr && device->cancelPulse( pin_, id ) ) completion.set( false );
+        } ), timeout );
+    }
+
+    return create_async( [ completion ]() -> task<bool> { return create_task( completion ); } );
+}
+
+
+//******************************************************************************
+//* Callbacks
+//******************************************************************************
+
+
+void
+RemoteDevice::onDigitalReport(
+    uint8_t port_,
+    uint16_t value_
+    )
+{
+    uint8_t port = port_;
+    uint8_t port_val = static_cast<uint8_t>( value_ );
+    uint8_t port_xor;
+
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+        //output_state will only set bits which correspond to output pins that are HIGH
+        uint8_t output_state = ~_subscribed_ports[port] & _digital_port[port];
+        port_val |= output_state;
+
+        //determine which pins have changed
+        port_xor = port_val ^ _digital_port[port];
+
+        //update the cache
+        _digital_port[port] = port_val;
+    }
+
+    //throw a pin event for each pin that has changed
+    uint8_t i = 0;
+    while( port_xor > 0 )
+    {
+        if( port_xor & 0x01 )
+        {
+            DigitalPinUpdated( ( port * 8 ) + i, ( ( port_val >> i ) & 0x01 ) > 0 ? PinState::HIGH : PinState::LOW );
+        }
+        port_xor >>= 1;
+        ++i;
+    }
+}
+
+void
+RemoteDevice::onAnalogReport(
+    uint8_t pin_,
+    uint16_t value_,
+    int64_t timestamp_
+    )
+{
+    uint8_t pin = pin_;
+    uint16_t val = value_;
+
+    std::vector<task_completion_event<uint16_t>> samples;
+
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+        _analog_pins[pin] = val;
+        _analog_report_time[pin] = std::chrono::steady_clock::now();
+
+        auto history = _analog_history.find( pin );
+        auto compressed = _compressed_history.find( pin );
+        if( history != _analog_history.end() ) history->second.append( timestamp_, val );
+        if( compressed != _compressed_history.end() ) compressed->second.append( timestamp_, val );
+
+        //this report completes any pending single-shot reads. A channel which is not reported continuously is stopped on any report,
+        //including one which arrives with no read pending, so a channel left reporting by a late enable is not left reporting forever.
+        //the disable is sent before the mutex is released, so it cannot follow the enable of a read queued after this report
+        samples.swap( _analog_samples[pin] );
+        if( !( _continuous_analog_reports & ( 1 << pin ) ) )
+        {
+            sendAnalogReporting( 1 << pin, false );
+        }
+    }
+
+    for( auto &sample : samples )
+    {
+        sample.set( val );
+    }
+
+    //throw an event for the pin value update
+    AnalogPinUpdated( L"A" + pin.ToString(), val );
+}
+
+void
+RemoteDevice::onReportBatch(
+    Firmata::ReportBatchEventArgs ^argv_
+    )
+{
+    //a batch holds the reports which would otherwise have been raised individually, so each is handled in order
+    Platform::Array<ReportRecord> ^records = argv_->getRecords();
+    for( unsigned int i = 0; i < records->Length; ++i )
+    {
+        const ReportRecord &record = records[i];
+        switch( record.Type )
+        {
+        case ReportType::DIGITAL_PORT:
+            onDigitalReport( record.Number, record.Value );
+            break;
+
+        case ReportType::ANALOG_PIN:
+            //the record carries the time it was parsed, which keeps the spacing of reports that were collected into one batch
+            onAnalogReport( record.Number, record.Value, record.Timestamp.UniversalTime );
+            break;
+        }
+    }
+}
+
+void
+RemoteDevice::onSysexMessage(
+    Firmata::SysexCallbackEventArgs ^argv_
+    )
+{
+    //the device reports the pin and the number of pulses generated once a pulse train has completed
+    if( argv_->getCommand() == static_cast<uint8_t>( SysexCommand::PULSE_DATA ) )
+    {
+        Windows::Storage::Streams::DataReader ^reader = Windows::Storage::Streams::DataReader::FromBuffer( argv_->getDataBuffer() );
+        if( !reader->UnconsumedBufferLength ) return;
+
+        uint8_t pin = reader->ReadByte();
+        task_completion_event<bool> completion;
+        {   //critical section
+            std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+            auto pending = _pending_pulses.find( pin );
+            if( pending == _pending_pulses.end() || pending->second.empty() ) return;
+
+            completion = pending->second.front().completion;
+            pending->second.pop_front();
+        }
+
+        completion.set( true );
+        return;
+    }
+
+    //the device reports its main loop time in microseconds, sysex buffer high-water mark, free RAM and receive overrun count
+    if( argv_->getCommand() == static_cast<uint8_t>( SysexCommand::TELEMETRY ) )
+    {
+        Windows::Storage::Streams::DataReader ^reader = Windows::Storage::Streams::DataReader::FromBuffer( argv_->getDataBuffer() );
+        if( reader->UnconsumedBufferLength < 14 ) return;
+
+        auto read_value = [ reader ]( int byte_count_ ) -> uint32_t
+        {
+            uint32_t value = 0;
+            for( int i = 0; i < byte_count_; ++i )
+            {
+                value |= static_cast<uint32_t>( reader->ReadByte() & 0x7F ) << ( 7 * i );
+            }
+            return value;
+        };
+
+        TimeSpan loop_time;
+        loop_time.Duration = static_cast<int64_t>( read_value( 4 ) ) * 10;
+        uint16_t sysex_high_water_mark = static_cast<uint16_t>( read_value( 2 ) );
+        uint32_t free_ram = read_value( 4 );
+        uint32_t rx_overruns = read_value( 4 );
+
+        DateTime timestamp;
+        timestamp.UniversalTime = currentUniversalTime();
+
+        DeviceTelemetry ^telemetry = ref new DeviceTelemetry( loop_time, sysex_high_water_mark, free_ram, rx_overruns, timestamp );
+        {   //critical section
+            std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+            _telemetry = telemetry;
+        }
+
+        TelemetryUpdated( telemetry );
+        return;
+    }
+
+    //the device confirms a deadband request by echoing it, with the channel, threshold and maximum silence each split over two 7-bit bytes
+    if( argv_->getCommand() == static_cast<uint8_t>( SysexCommand::ANALOG_DEADBAND ) )
+    {
+        Windows::Storage::Streams::DataReader ^reader = Windows::Storage::Streams::DataReader::FromBuffer( argv_->getDataBuffer() );
+        if( reader->UnconsumedBufferLength < 5 ) return;
+
+        uint8_t channel = reader->ReadByte();
+        uint16_t threshold = reader->ReadByte();
+        threshold |= reader->ReadByte() << 7;
+        uint16_t max_silence_millis = reader->ReadByte();
+        max_silence_millis |= reader->ReadByte() << 7;
+        if( channel >= MAX_ANALOG_PINS ) return;
+
+        //an echo of a request which has since been replaced does not confirm the current one
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+        auto request = _deadband_requests.find( channel );
+        bool current = ( request != _deadband_requests.end() && request->second == std::make_pair( threshold, max_silence_millis ) );
+        _confirmed_deadband_silence[channel] = current ? max_silence_millis : 0;
+        return;
+    }
+
+    //the device confirms an oversampling request with the channel, sample count shift, mode and the resulting resolution
+    if( argv_->getCommand() == static_cast<uint8_t>( SysexCommand::ANALOG_OVERSAMPLING ) )
+    {
+        Windows::Storage::Streams::DataReader ^reader = Windows::Storage::Streams::DataReader::FromBuffer( argv_->getDataBuffer() );
+        if( reader->UnconsumedBufferLength < 4 ) return;
+
+        uint8_t channel = reader->ReadByte();
+        uint8_t shift = reader->ReadByte();
+        reader->ReadByte();
+        uint8_t resolution = reader->ReadByte();
+        if( channel >= MAX_ANALOG_PINS || shift > MAX_OVERSAMPLING_SHIFT ) return;
+
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+        _analog_oversampling[channel] = shift;
+        if( _initialized )
+        {
+            _hardwareProfile->setAnalogResolution( channel + _hardwareProfile->AnalogOffset, resolution );
+        }
+        return;
+    }
+
+    SysexMessageReceived( argv_->getCommand(), Windows::Storage::Streams::DataReader::FromBuffer( argv_->getDataBuffer() ) );
+}
+
+void
+RemoteDevice::onStringMessage(
+    Firmata::StringCallbackEventArgs ^argv_
+    )
+{
+    StringMessageReceived( argv_->getString() );
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+void const
+RemoteDevice::initialize(
+    HardwareProfile ^hardwareProfile_
+    )
+{
+    {   //critical section equivalent to function scope
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        if( _initialized ) return;
         _hardwareProfile = hardwareProfile_;
-        _firmata->DigitalPortValueUpdated += ref new Firmata::CallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::CallbackEventArgs^ args ) -> void { onDigitalReport( args ); } );
-        _firmata->AnalogValueUpdated += ref new Firmata::CallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::CallbackEventArgs^ args ) -> void { onAnalogReport( args ); } );
+        _firmata->DigitalPortValueUpdated += ref new Firmata::CallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::CallbackEventArgs^ args ) -> void { onDigitalReport( args->getPort(), args->getValue() ); } );
+        _firmata->AnalogValueUpdated += ref new Firmata::CallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::CallbackEventArgs^ args ) -> void { onAnalogReport( args->getPort(), args->getValue(), currentUniversalTime() ); } );
+        _firmata->ReportBatchReceived += ref new Firmata::ReportBatchCallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::ReportBatchEventArgs^ args ) -> void { onReportBatch( args ); } );
         _firmata->SysexMessageReceived += ref new Firmata::SysexCallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::SysexCallbackEventArgs^ args ) -> void { onSysexMessage( args ); } );
         _firmata->StringMessageReceived += ref new Firmata::StringCallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::StringCallbackEventArgs^ args ) -> void { onStringMessage( args ); } );
 
@@ -436,6 +1207,10 @@ RemoteDevice::initialize(
         std::fill( _subscribed_ports.begin(), _subscribed_ports.end(), 0 );
         std::fill( _analog_pins.begin(), _analog_pins.end(), 0 );
         std::fill( _pin_mode.begin(), _pin_mode.end(), static_cast<uint8_t>( PinMode::OUTPUT ) );
+        std::fill( _analog_output.begin(), _analog_output.end(), static_cast<uint16_t>( UNKNOWN_ANALOG_OUTPUT ) );
+        std::fill( _analog_oversampling.begin(), _analog_oversampling.end(), 0 );
+        std::fill( _confirmed_deadband_silence.begin(), _confirmed_deadband_silence.end(), 0 );
+        _continuous_analog_reports = 0;
 
         _initialized = true;
     }
@@ -526,6 +1301,45 @@ RemoteDevice::onConnectionLost(
     Platform::String^ message_
     )
 {
+    //pending single-shot reads and pulse trains can no longer be completed
+    std::vector<task_completion_event<uint16_t>> samples;
+    std::vector<task_completion_event<bool>> pulses;
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+        for( auto &pending : _analog_samples )
+        {
+            samples.insert( samples.end(), pending.begin(), pending.end() );
+            pending.clear();
+        }
+
+        for( auto &pending : _pending_pulses )
+        {
+            for( auto &pulse : pending.second )
+            {
+                pulses.push_back( pulse.completion );
+            }
+        }
+        _pending_pulses.clear();
+
+        //the device may be reset before the connection is restored, so deadbands are only relied upon again once they are confirmed again
+        std::fill( _confirmed_deadband_silence.begin(), _confirmed_deadband_silence.end(), 0 );
+    }
+
+    for( auto &sample : samples )
+    {
+        sample.set( static_cast<uint16_t>( -1 ) );
+    }
+
+    for( auto &pulse : pulses )
+    {
+        pulse.set( false );
+    }
+
+    if( _twoWire != nullptr )
+    {
+        _twoWire->onConnectionLost();
+    }
+
     DeviceConnectionLost( message_ );
 }
 
@@ -534,7 +1348,29 @@ RemoteDevice::onConnectionReady(
     void
     )
 {
-    _firmata->PinCapabilityResponseReceived += ref new Microsoft::Maker::Firmata::SysexCallbackFunction( this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onPinCapabilityResponseReceived );
+    //a previously initialized device is reconnecting, so it only needs the state which changed while the connection was down
+    if( _initialized )
+    {
+        sendShadowState();
+    }
+    else
+    {
+        _firmata->PinCapabilityResponseReceived += ref new Microsoft::Maker::Firmata::SysexCallbackFunction( this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onPinCapabilityResponseReceived );
+    }
+
+    //in polling mode there are no threads of our own, the handshake is driven by calls to poll()
+    if( _firmata->pollingMode() )
+    {
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+        if( !_initialized )
+        {
+            sendCapabilityQuery();
+        }
+        _polled_handshake_attempts = 1;
+        _polled_handshake_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( HANDSHAKE_RETRY_MILLIS );
+        return;
+    }
+
     _firmata->startListening();
 
 	//this async task will send a request for pin capability report from the device, wait for increasing intervals as long as the device
@@ -542,7 +1378,6 @@ RemoteDevice::onConnectionReady(
 	//the process for a set number of attempts. A device response will be received in the form of a PinCapabilityResponseReceived event.
     Concurrency::create_task( [ this ]
     {
-        const int MAX_ATTEMPTS = 30;
 		const int MAX_DELAY_LOOP = 5;
 		const int INIT_DELAY_MS = 10;
         int attempts = 0;
@@ -558,23 +1393,10 @@ RemoteDevice::onConnectionReady(
                 if( _initialized ) return true;
             }
 
-            if( attempts >= MAX_ATTEMPTS ) return false;
-
-            //manually sending a sysex message asking for the pin configuration will guarantee it is sent properly even if a user has started a sysex message themselves
-            _firmata->lock();
-            try
-            {
-                _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
-                _firmata->write( static_cast<uint8_t>( SysexCommand::CAPABILITY_QUERY ) );
-                _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
-                _firmata->flush();
-            }
-            catch( ... )
-            {
-                //if an error occurs here we count it as an attempt and continue.
-            }
+            if( attempts >= HANDSHAKE_MAX_ATTEMPTS ) return false;
 
-            _firmata->unlock();
+            //if an error occurs while sending we count it as an attempt and continue.
+            sendCapabilityQuery();
             ++attempts;
 			
 			//this loop is responsible for waiting at increasing intervals until the response is received or MAX_DELAY_LOOP number of iterations have occurred.
@@ -623,6 +1445,336 @@ RemoteDevice::onPinCapabilityResponseReceived(
     }
 }
 
+bool
+RemoteDevice::queueAnalogSample(
+    uint8_t parsed_pin_,
+    task_completion_event<uint16_t> sample_
+    )
+{
+    //critical section equivalent to function scope
+    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+    //verify that we were given a valid analog pin number, parsePinFromAnalogString returns -1 as uint if the string is invalid, so this will catch both cases
+    if( !_initialized || !_firmata->connectionReady() || parsed_pin_ >= _hardwareProfile->AnalogPinCount || parsed_pin_ >= MAX_ANALOG_PINS )
+    {
+        sample_.set( static_cast<uint16_t>( -1 ) );
+        return false;
+    }
+
+    uint8_t analog_pin_num = parsed_pin_ + _hardwareProfile->AnalogOffset;
+    bool enable_reporting = false;
+
+    if( _pin_mode[analog_pin_num] != static_cast<uint8_t>( PinMode::ANALOG ) )
+    {
+        //the device enables reporting when a pin is changed to analog mode, so there is no need to enable it again
+        pinMode( analog_pin_num, PinMode::ANALOG );
+        if( _pin_mode[analog_pin_num] != static_cast<uint8_t>( PinMode::ANALOG ) )
+        {
+            sample_.set( static_cast<uint16_t>( -1 ) );
+            return false;
+        }
+        _continuous_analog_reports &= ~( 1 << parsed_pin_ );
+    }
+    else
+    {
+        //reporting only needs to be enabled by the first pending read of a channel which is not reported continuously
+        enable_reporting = _analog_samples[parsed_pin_].empty() && !( _continuous_analog_reports & ( 1 << parsed_pin_ ) );
+    }
+
+    _analog_samples[parsed_pin_].push_back( sample_ );
+    return enable_reporting;
+}
+
+void
+RemoteDevice::setContinuousAnalogReport(
+    uint8_t pin_,
+    PinMode mode_
+    )
+{
+    //the device reports analog pins continuously while they are in analog mode
+    int analog_channel = pin_ - _hardwareProfile->AnalogOffset;
+    if( analog_channel < 0 || analog_channel >= static_cast<int>( MAX_ANALOG_PINS ) ) return;
+
+    if( mode_ == PinMode::ANALOG )
+    {
+        _continuous_analog_reports |= ( 1 << analog_channel );
+    }
+    else
+    {
+        _continuous_analog_reports &= ~( 1 << analog_channel );
+    }
+}
+
+bool
+RemoteDevice::cancelPulse(
+    uint8_t pin_,
+    uint32_t id_
+    )
+{
+    //critical section equivalent to function scope
+    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+    auto pending = _pending_pulses.find( pin_ );
+    if( pending == _pending_pulses.end() ) return false;
+
+    for( auto it = pending->second.begin(); it != pending->second.end(); ++it )
+    {
+        if( it->id != id_ ) continue;
+        pending->second.erase( it );
+        return true;
+    }
+    return false;
+}
+
+void
+RemoteDevice::sendAnalogReporting(
+    uint16_t channels_,
+    bool enabled_
+    )
+{
+    _firmata->lock();
+    try
+    {
+        for( uint8_t channel = 0; channel < MAX_ANALOG_PINS; ++channel )
+        {
+            if( !( channels_ & ( 1 << channel ) ) ) continue;
+            _firmata->write( static_cast<uint8_t>( Firmata::Command::REPORT_ANALOG_PIN ) | channel );
+            _firmata->write( enabled_ ? 1 : 0 );
+        }
+        _firmata->flush();
+    }
+    catch( ... )
+    {
+        //something has gone wrong, any fatal errors should be evented
+    }
+    _firmata->unlock();
+}
+
+bool
+RemoteDevice::sendStateChanges(
+    const std::bitset<MAX_PINS> &pin_modes_,
+    const std::bitset<MAX_PORTS> &subscriptions_,
+    const std::bitset<MAX_PORTS> &ports_,
+    const std::map<uint8_t, uint16_t> &analog_values_
+    )
+{
+    //critical section equivalent to function scope
+    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+    _firmata->lock();
+    try
+    {
+        for( size_t pin = 0; pin < MAX_PINS; ++pin )
+        {
+            if( !pin_modes_.test( pin ) ) continue;
+            _firmata->write( static_cast<uint8_t>( Firmata::Command::SET_PIN_MODE ) );
+            _firmata->write( static_cast<uint8_t>( pin ) );
+            _firmata->write( _pin_mode[pin] );
+        }
+
+        for( size_t port = 0; port < MAX_PORTS; ++port )
+        {
+            if( !subscriptions_.test( port ) ) continue;
+            _firmata->write( static_cast<uint8_t>( Firmata::Command::REPORT_DIGITAL_PIN ) | ( port & 0x0F ) );
+            _firmata->write( _subscribed_ports[port] );
+        }
+
+        for( size_t port = 0; port < MAX_PORTS; ++port )
+        {
+            if( !ports_.test( port ) ) continue;
+            _firmata->write( static_cast<uint8_t>( Firmata::Command::DIGITAL_MESSAGE ) | ( port & 0x0F ) );
+            _firmata->write( _digital_port[port] & 0x7F );
+            _firmata->write( _digital_port[port] >> 7 );
+        }
+
+        for( auto &analog : analog_values_ )
+        {
+            //a pin may have changed modes after the value was written
+            if( _pin_mode[analog.first] != static_cast<uint8_t>( PinMode::PWM ) && _pin_mode[analog.first] != static_cast<uint8_t>( PinMode::SERVO ) ) continue;
+            _firmata->write( static_cast<uint8_t>( Firmata::Command::ANALOG_MESSAGE ) | ( analog.first & 0x0F ) );
+            _firmata->write( analog.second & 0x7F );
+            _firmata->write( ( analog.second >> 7 ) & 0x7F );
+        }
+
+        _firmata->flush();
+    }
+    catch( ... )
+    {
+        //something has gone wrong, any fatal errors should be evented, so we need to exit this function
+        _firmata->unlock();
+        return false;
+    }
+
+    _firmata->unlock();
+    return true;
+}
+
+bool
+RemoteDevice::sendAnalogDeadband(
+    uint8_t channel_,
+    uint16_t threshold_,
+    uint16_t max_silence_millis_
+    )
+{
+    if( !_firmata->connectionReady() ) return false;
+
+    bool sent = true;
+    _firmata->lock();
+    try
+    {
+        _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
+        _firmata->write( static_cast<uint8_t>( SysexCommand::ANALOG_DEADBAND ) );
+        _firmata->write( channel_ );
+        _firmata->write( threshold_ & 0x7F );
+        _firmata->write( ( threshold_ >> 7 ) & 0x7F );
+        _firmata->write( max_silence_millis_ & 0x7F );
+        _firmata->write( ( max_silence_millis_ >> 7 ) & 0x7F );
+        _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
+        _firmata->flush();
+    }
+    catch( ... )
+    {
+        sent = false;
+    }
+    _firmata->unlock();
+
+    return sent;
+}
+
+bool
+RemoteDevice::sendAnalogOversampling(
+    uint8_t channel_,
+    uint8_t request_
+    )
+{
+    if( !_firmata->connectionReady() ) return false;
+
+    bool sent = true;
+    _firmata->lock();
+    try
+    {
+        _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
+        _firmata->write( static_cast<uint8_t>( SysexCommand::ANALOG_OVERSAMPLING ) );
+        _firmata->write( channel_ );
+        _firmata->write( request_ & 0x07 );
+        _firmata->write( request_ >> 3 );
+        _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
+        _firmata->flush();
+    }
+    catch( ... )
+    {
+        sent = false;
+    }
+    _firmata->unlock();
+
+    return sent;
+}
+
+void
+RemoteDevice::sendCapabilityQuery(
+    void
+    )
+{
+    //manually sending a sysex message asking for the pin configuration will guarantee it is sent properly even if a user has started a sysex message themselves
+    _firmata->lock();
+    try
+    {
+        _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
+        _firmata->write( static_cast<uint8_t>( SysexCommand::CAPABILITY_QUERY ) );
+        _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
+        _firmata->flush();
+    }
+    catch( ... )
+    {
+    }
+
+    _firmata->unlock();
+}
+
+void
+RemoteDevice::sendShadowState(
+    void
+    )
+{
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        //if the connection is lost again, the shadow state is kept so it can be sent on the next attempt
+        if( ( _shadow_pin_modes.any() || _shadow_subscriptions.any() || _shadow_ports.any() || !_shadow_analog.empty() )
+            && sendStateChanges( _shadow_pin_modes, _shadow_subscriptions, _shadow_ports, _shadow_analog ) )
+        {
+            _shadow_pin_modes.reset();
+            _shadow_subscriptions.reset();
+            _shadow_ports.reset();
+            _shadow_analog.clear();
+        }
+    }
+
+    //oversampling and deadband requests are sent again, as the device reports raw values at every interval after a reset
+    std::map<uint8_t, uint8_t> oversampling_requests;
+    std::map<uint8_t, std::pair<uint16_t, uint16_t>> deadband_requests;
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+        oversampling_requests = _oversampling_requests;
+        deadband_requests = _deadband_requests;
+    }
+
+    for( auto &request : oversampling_requests )
+    {
+        sendAnalogOversampling( request.first, request.second );
+    }
+
+    for( auto &request : deadband_requests )
+    {
+        sendAnalogDeadband( request.first, request.second.first, request.second.second );
+    }
+
+    //I2C writes are shadowed by the TwoWire instance
+    if( _twoWire != nullptr )
+    {
+        _twoWire->sendShadowWrites();
+    }
+
+    //the keypad matrix must be configured again for the device to resume scanning
+    if( _keypad != nullptr )
+    {
+        _keypad->sendConfiguration();
+    }
+}
+
+void
+RemoteDevice::sendTelemetryQuery(
+    void
+    )
+{
+    if( !_firmata->connectionReady() ) return;
+
+    _firmata->lock();
+    try
+    {
+        _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
+        _firmata->write( static_cast<uint8_t>( SysexCommand::TELEMETRY ) );
+        _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
+        _firmata->flush();
+    }
+    catch( ... )
+    {
+        //something has gone wrong, any fatal errors should be evented
+    }
+    _firmata->unlock();
+}
+
+int64_t
+RemoteDevice::currentUniversalTime(
+    void
+    )
+{
+    //DateTime uses 100ns intervals since January 1, 1601 (UTC), the same representation as FILETIME
+    FILETIME now;
+    GetSystemTimePreciseAsFileTime( &now );
+    return ( static_cast<int64_t>( now.dwHighDateTime ) << 32 ) | now.dwLowDateTime;
+}
+
 uint8_t
 RemoteDevice::parsePinFromAnalogString(
     Platform::String^ string_
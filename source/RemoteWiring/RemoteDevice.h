@@ -24,10 +24,19 @@
 
 #pragma once
 
+#include <bitset>
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <map>
 #include <mutex>
+#include <vector>
 #include "TwoWire.h"
+#include "Keypad.h"
 #include "HardwareProfile.h"
+#include "CompressedHistory.h"
+#include "DeviceTelemetry.h"
+#include "PinHistory.h"
 
 namespace Microsoft {
 namespace Maker {
@@ -56,18 +65,38 @@ public enum class PinState
     HIGH = 0x01,
 };
 
+public enum class OversamplingMode
+{
+    AVERAGE = 0x00,
+    DECIMATE = 0x01,
+};
+
+ref class BoardState;
+ref class StateChangeSummary;
+
 public delegate void DigitalPinUpdatedCallback( uint8_t pin, PinState state );
 public delegate void AnalogPinUpdatedCallback( Platform::String ^pin, uint16_t value );
 public delegate void SysexMessageReceivedCallback( uint8_t command, Windows::Storage::Streams::DataReader ^message );
 public delegate void StringMessageReceivedCallback( Platform::String ^message );
 public delegate void RemoteDeviceConnectionCallback();
 public delegate void RemoteDeviceConnectionCallbackWithMessage( Platform::String ^message );
+public delegate void TelemetryCallbackFunction( DeviceTelemetry ^telemetry );
+
+//a pulse train awaiting completion, the identifier allows a train which the device never reports to be withdrawn
+struct PendingPulse
+{
+    uint32_t id;
+    Concurrency::task_completion_event<bool> completion;
+};
 
 public ref class RemoteDevice sealed {
 
     //singleton reference for I2C
     I2c::TwoWire ^_twoWire;
 
+    //singleton reference for the keypad matrix
+    Keypad::KeypadMatrix ^_keypad;
+
 public:
     event DigitalPinUpdatedCallback ^ DigitalPinUpdated;
     event AnalogPinUpdatedCallback ^ AnalogPinUpdated;
@@ -76,6 +105,7 @@ public:
     event RemoteDeviceConnectionCallback ^ DeviceReady;
     event RemoteDeviceConnectionCallbackWithMessage ^ DeviceConnectionFailed;
     event RemoteDeviceConnectionCallbackWithMessage ^ DeviceConnectionLost;
+    event TelemetryCallbackFunction ^ TelemetryUpdated;
 
     property I2c::TwoWire ^ I2c
     {
@@ -89,6 +119,30 @@ public:
         }
     };
 
+    property Keypad::KeypadMatrix ^ Keypad
+    {
+        Microsoft::Maker::RemoteWiring::Keypad::KeypadMatrix ^ get()
+        {
+            if( _keypad == nullptr )
+            {
+                _keypad = ref new Microsoft::Maker::RemoteWiring::Keypad::KeypadMatrix( _firmata );
+            }
+            return _keypad;
+        }
+    };
+
+    ///<summary>
+    ///The telemetry most recently reported by the device, or nullptr if none has been received.
+    ///</summary>
+    property DeviceTelemetry ^ Telemetry
+    {
+        DeviceTelemetry ^ get()
+        {
+            std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+            return _telemetry;
+        }
+    }
+
     property HardwareProfile ^ DeviceHardwareProfile
     {
         Microsoft::Maker::RemoteWiring::HardwareProfile ^ get()
@@ -124,6 +178,28 @@ public:
         Platform::String ^analog_pin_
     );
 
+    ///<summary>
+    ///Reads a single fresh sample from the given analog pin without leaving continuous reporting enabled.
+    ///<para>Reporting is enabled for the pin only until the next report is received. If the pin is not yet in PinMode.ANALOG, it will be changed.
+    ///Concurrent reads of the same pin share a single sample. If the read cannot be performed, the operation completes with the value 0xFFFF.</para>
+    ///<param name="analog_pin_">The analog pin string, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
+    ///</summary>
+    [Windows::Foundation::Metadata::DefaultOverloadAttribute]
+    Windows::Foundation::IAsyncOperation<uint16_t> ^
+    analogReadAsync(
+        Platform::String ^analog_pin_
+    );
+
+    ///<summary>
+    ///Reads a single fresh sample from each of the given analog pins, enabling reporting for all of them with a single flush.
+    ///<param name="analog_pins_">The analog pin strings, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
+    ///<returns>the sampled values, in the order the pins were given</returns>
+    ///</summary>
+    Windows::Foundation::IAsyncOperation<Windows::Foundation::Collections::IVectorView<uint16_t> ^> ^
+    analogReadAsync(
+        Windows::Foundation::Collections::IIterable<Platform::String ^> ^analog_pins_
+    );
+
     ///<summary>
     ///Sets the value of the given pin to the given analog value.
     ///<para>This function should only be called for pins that support PWM. If the given pin is in 
@@ -137,6 +213,18 @@ public:
         uint16_t value_
     );
 
+    ///<summary>
+    ///Brings the device to the given desired state, sending only the changes required from the cached state in a single flush.
+    ///<para>Pin modes are always applied before digital states and analog values. Entries which are not supported by the device,
+    ///or which do not match the resulting pin mode, are ignored.</para>
+    ///<param name="desired_state_">The complete desired output configuration of the device.</param>
+    ///<returns>a summary of the changes which were sent to the device</returns>
+    ///</summary>
+    StateChangeSummary ^
+    applyState(
+        BoardState ^desired_state_
+    );
+
     ///<summary>
     ///Returns the most recently-reported value for the given digital pin.
     ///<para>Analog pins must first be in PinMode.INPUT before their values will be reported.</para>
@@ -212,12 +300,175 @@ public:
         Platform::String ^analog_pin_
         );
 
+    ///<summary>
+    ///Returns the time since the cached value of the given analog pin was last known to be current.
+    ///<para>A pin with a deadband the device has confirmed is known to be unchanged until its maximum silence period runs out, so its age
+    ///remains zero between reports until then, as long as the pin is reported continuously. If no value has been reported for the pin,
+    ///the maximum TimeSpan is returned.</para>
+    ///<param name="analog_pin_">The analog pin string, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
+    ///</summary>
+    Windows::Foundation::TimeSpan
+    getAnalogAge(
+        Platform::String ^analog_pin_
+    );
+
+    ///<summary>
+    ///Summarizes the history kept for the given analog pin between the given times into no more than the given number of bins, such as one per pixel of a chart.
+    ///<para>The summaries are taken from the finest level of history which covers the range, so the time taken depends on the number of bins rather than
+    ///the number of samples. Bins without samples are omitted, and an empty array is returned if no history is kept for the pin.</para>
+    ///<param name="analog_pin_">The analog pin string, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
+    ///<param name="start_">The start of the range.</param>
+    ///<param name="end_">The end of the range.</param>
+    ///<param name="width_">The number of bins to divide the range into.</param>
+    ///</summary>
+    Platform::Array<HistorySummary> ^
+    getAnalogHistory(
+        Platform::String ^analog_pin_,
+        Windows::Foundation::DateTime start_,
+        Windows::Foundation::DateTime end_,
+        uint32_t width_
+    );
+
+    ///<summary>
+    ///Returns every value reported by the given analog pin between the given times, decoded from the compressed history kept for the pin.
+    ///<para>An empty array is returned if no compressed history is kept for the pin, or if the range has already been discarded.</para>
+    ///<param name="analog_pin_">The analog pin string, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
+    ///<param name="start_">The start of the range.</param>
+    ///<param name="end_">The end of the range.</param>
+    ///</summary>
+    Platform::Array<HistorySample> ^
+    getAnalogSamples(
+        Platform::String ^analog_pin_,
+        Windows::Foundation::DateTime start_,
+        Windows::Foundation::DateTime end_
+    );
+
+    ///<summary>
+    ///Returns the number of samples the device combines into each reported value of the given analog pin, or 1 if raw samples are reported.
+    ///<para>The setting only takes effect once the device has confirmed it, values reported before then are raw.</para>
+    ///<param name="analog_pin_">The analog pin string, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
+    ///</summary>
+    uint8_t
+    getAnalogOversampling(
+        Platform::String ^analog_pin_
+    );
+
+    ///<summary>
+    ///Asks the device to report the given analog pin only when its value moves by more than the given threshold, or when the maximum silence
+    ///period runs out, using the ANALOG_DEADBAND extension.
+    ///<para>A threshold of 0 restores the default behavior of reporting at every sampling interval. The setting is only relied upon by
+    ///getAnalogAge once the device has confirmed it, firmware which does not implement the extension leaves the pin reporting every interval.</para>
+    ///<param name="analog_pin_">The analog pin string, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
+    ///<param name="threshold_">The change in value required before a report is sent.</param>
+    ///<param name="max_silence_millis_">The longest time the device may go without reporting the pin.</param>
+    ///</summary>
+    void
+    setAnalogDeadband(
+        Platform::String ^analog_pin_,
+        uint16_t threshold_,
+        uint16_t max_silence_millis_
+    );
+
+    ///<summary>
+    ///Begins keeping a history of the values reported by the given analog pin, or stops if the capacity is 0.
+    ///<para>Every value is kept along with summaries of the minimum, maximum and mean at power-of-two multiples of the sampling interval.
+    ///Each level keeps the given number of entries, so coarser levels reach further into the past, at roughly 32 bytes per entry for each of 24 levels.
+    ///Any history already kept for the pin is discarded.</para>
+    ///<param name="analog_pin_">The analog pin string, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
+    ///<param name="capacity_">The number of entries to keep at each level.</param>
+    ///</summary>
+    void
+    setAnalogHistory(
+        Platform::String ^analog_pin_,
+        uint32_t capacity_
+    );
+
+    ///<summary>
+    ///Begins keeping every value reported by the given analog pin in compressed blocks, or stops if the budget is 0.
+    ///<para>A steady signal at a steady rate costs a few bits per sample. Once the history reaches the given size, the oldest block of samples
+    ///is discarded to make room for the next. Any compressed history already kept for the pin is discarded.</para>
+    ///<param name="analog_pin_">The analog pin string, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
+    ///<param name="budget_bytes_">The memory the history of the pin may use.</param>
+    ///</summary>
+    void
+    setCompressedAnalogHistory(
+        Platform::String ^analog_pin_,
+        uint32_t budget_bytes_
+    );
+
+    ///<summary>
+    ///Queries the device for its telemetry at the given interval using the TELEMETRY extension, or stops if the interval is 0.
+    ///<para>Each reply updates the Telemetry property and is raised as a TelemetryUpdated event. No queries are sent while the connection is down.</para>
+    ///<param name="interval_millis_">The time between queries.</param>
+    ///</summary>
+    void
+    setTelemetryInterval(
+        uint32_t interval_millis_
+    );
+
+    ///<summary>
+    ///Asks the device to combine the given number of samples into each reported value of the given analog pin, using the ANALOG_OVERSAMPLING extension.
+    ///<para>OversamplingMode.AVERAGE reports the mean of the samples. OversamplingMode.DECIMATE adds one bit of resolution for each fourfold
+    ///increase in the sample count, so 4 samples add 1 bit, 16 add 2 and 64 add 3, and the analog resolution of the DeviceHardwareProfile
+    ///is updated once the device confirms the setting.</para>
+    ///<param name="analog_pin_">The analog pin string, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
+    ///<param name="sample_count_">The number of samples, a power of two up to 64. A count of 1 restores raw reports.</param>
+    ///<param name="mode_">How the samples are combined.</param>
+    ///</summary>
+    void
+    setAnalogOversampling(
+        Platform::String ^analog_pin_,
+        uint8_t sample_count_,
+        OversamplingMode mode_
+    );
+
+    ///<summary>
+    ///Processes input on the caller's thread when the UwpFirmata object given to this RemoteDevice is in polling mode.
+    ///<para>No input thread or handshake task is created in polling mode. The capability query is retried from within this call,
+    ///and DeviceReady or DeviceConnectionFailed is raised from it once handshaking has completed.</para>
+    ///<param name="timeout_millis_">The maximum time to wait for input to arrive.</param>
+    ///<returns>the number of messages which were processed</returns>
+    ///</summary>
+    uint32_t
+    poll(
+        uint32_t timeout_millis_
+    );
+
+    ///<summary>
+    ///Asks the device to generate a train of pulses on the given pin using the PULSE_DATA extension, which are timed by the device itself.
+    ///<para>The pin must be in PinMode.OUTPUT. It is held at the opposite of the given state between pulses and once the train has completed.</para>
+    ///<param name="pin_">A raw pin number which will be treated "as is" and used exactly as given.</param>
+    ///<param name="state_">The state of the pin during each pulse.</param>
+    ///<param name="width_micros_">The width of each pulse in microseconds.</param>
+    ///<param name="count_">The number of pulses to generate.</param>
+    ///<param name="period_micros_">The time from the start of one pulse to the start of the next, ignored for a single pulse.</param>
+    ///<returns>an operation which completes with true once the device reports the pulses have been generated, or false if they could not be.
+    ///Firmware which does not implement the extension never reports the train, so the operation completes with false once the train's duration
+    ///and a short margin have passed without a report. A period shorter than the width is rejected for a train of more than one pulse.</returns>
+    ///</summary>
+    Windows::Foundation::IAsyncOperation<bool> ^
+    pulseAsync(
+        uint8_t pin_,
+        PinState state_,
+        uint32_t width_micros_,
+        uint16_t count_,
+        uint32_t period_micros_
+    );
+
 
 private:
     //constant members
     static const size_t MAX_PORTS = 16;
     static const size_t MAX_PINS = 128;
     static const size_t MAX_ANALOG_PINS = 16;
+    static const uint16_t UNKNOWN_ANALOG_OUTPUT = 0xFFFF;
+    static const int HANDSHAKE_MAX_ATTEMPTS = 30;
+    static const int HANDSHAKE_RETRY_MILLIS = 310;
+    static const uint8_t MAX_OVERSAMPLING_SHIFT = 6;
+    static const uint16_t MAX_DEADBAND_VALUE = 0x3FFF;
+    static const uint32_t MAX_PULSE_MICROS = 0x0FFFFFFF;
+    static const uint16_t MAX_PULSE_COUNT = 0x3FFF;
+    static const int64_t PULSE_TIMEOUT_MARGIN_MILLIS = 500;
 
     //initialized state member
     std::atomic_bool _initialized;
@@ -239,6 +490,44 @@ private:
     std::array<std::atomic_uint8_t, MAX_PORTS> _digital_port;
     std::array<std::atomic_uint16_t, MAX_ANALOG_PINS> _analog_pins;
     std::array<std::atomic_uint8_t, MAX_PINS> _pin_mode;
+    std::array<std::atomic_uint16_t, MAX_PINS> _analog_output;
+
+    //single-shot analog reads, the channels in the bitmask are reported continuously and must not be disabled after a sample
+    std::atomic_uint16_t _continuous_analog_reports;
+    std::array<std::vector<Concurrency::task_completion_event<uint16_t>>, MAX_ANALOG_PINS> _analog_samples;
+
+    //shadow state, marks the cached values which were changed while the connection was down and must be sent once it is restored
+    std::bitset<MAX_PINS> _shadow_pin_modes;
+    std::bitset<MAX_PORTS> _shadow_subscriptions;
+    std::bitset<MAX_PORTS> _shadow_ports;
+    std::map<uint8_t, uint16_t> _shadow_analog;
+
+    //analog oversampling, the confirmed sample count of each channel as a power of two and the requests to send again after a reconnect
+    //K = analog channel, V = ( mode << 3 ) | sample count shift
+    std::array<std::atomic_uint8_t, MAX_ANALOG_PINS> _analog_oversampling;
+    std::map<uint8_t, uint8_t> _oversampling_requests;
+
+    //analog deadbands and report times, guarded by _device_mutex. K = analog channel, V = ( threshold, maximum silence in milliseconds )
+    //the maximum silence of each channel is only set once the device has confirmed its deadband, 0 means no deadband is confirmed
+    std::map<uint8_t, std::pair<uint16_t, uint16_t>> _deadband_requests;
+    std::array<uint16_t, MAX_ANALOG_PINS> _confirmed_deadband_silence;
+    std::array<std::chrono::steady_clock::time_point, MAX_ANALOG_PINS> _analog_report_time;
+
+    //analog history summaries and compressed samples, guarded by _device_mutex. K = analog channel
+    std::map<uint8_t, PinHistory> _analog_history;
+    std::map<uint8_t, CompressedHistory> _compressed_history;
+
+    //device telemetry, the latest report is guarded by _device_mutex
+    DeviceTelemetry ^_telemetry;
+    Windows::System::Threading::ThreadPoolTimer ^_telemetry_timer;
+
+    //pulse trains awaiting completion, guarded by _device_mutex. K = pin number, V = the pulse trains sent to the pin in order
+    std::map<uint8_t, std::deque<PendingPulse>> _pending_pulses;
+    uint32_t _next_pulse_id;
+
+    //handshake state when driven by poll(), a non-zero attempt count means handshaking is in progress
+    int _polled_handshake_attempts;
+    std::chrono::steady_clock::time_point _polled_handshake_deadline;
 
     //maps the given pin number to the correct port and mask
     void
@@ -253,12 +542,88 @@ private:
         PinMode mode_
         );
 
+    //keeps the continuous report bit of an analog pin in step with a change of its mode, must be called with _device_mutex held
+    void
+    setContinuousAnalogReport(
+        uint8_t pin_,
+        PinMode mode_
+    );
+
+    //registers a single-shot read of the given analog pin, returns true if reporting must be enabled for it
+    bool
+    queueAnalogSample(
+        uint8_t parsed_pin_,
+        Concurrency::task_completion_event<uint16_t> sample_
+    );
+
+    //withdraws the given pulse train if it is still awaiting completion, returns false if it has already completed
+    bool
+    cancelPulse(
+        uint8_t pin_,
+        uint32_t id_
+    );
+
+    //enables or disables reporting for each analog channel in the bitmask with a single flush
+    void
+    sendAnalogReporting(
+        uint16_t channels_,
+        bool enabled_
+    );
+
+    //returns the current time in the same representation as DateTime, using the same clock as the report timestamps of UwpFirmata
+    static
+    int64_t
+    currentUniversalTime(
+        void
+    );
+
     //returns a uint8_t type parsed from a Platform::String ^
     uint8_t
     parsePinFromAnalogString(
         Platform::String^ string_
     );
 
+    //sends the given changes from the cache as a single batch with a single flush, pin modes are always sent before values
+    bool
+    sendStateChanges(
+        const std::bitset<MAX_PINS> &pin_modes_,
+        const std::bitset<MAX_PORTS> &subscriptions_,
+        const std::bitset<MAX_PORTS> &ports_,
+        const std::map<uint8_t, uint16_t> &analog_values_
+    );
+
+    //sends a deadband request for the given analog channel, returns false if it could not be sent
+    bool
+    sendAnalogDeadband(
+        uint8_t channel_,
+        uint16_t threshold_,
+        uint16_t max_silence_millis_
+    );
+
+    //sends an oversampling request for the given analog channel, returns false if it could not be sent
+    bool
+    sendAnalogOversampling(
+        uint8_t channel_,
+        uint8_t request_
+    );
+
+    //manually sends a capability query, guaranteeing it is sent properly even if a user has started a sysex message themselves
+    void
+    sendCapabilityQuery(
+        void
+    );
+
+    //sends the coalesced shadow state recorded while the connection was down
+    void
+    sendShadowState(
+        void
+    );
+
+    void
+    sendTelemetryQuery(
+        void
+    );
+
     //connection callbacks
     void
     onConnectionReady(
@@ -278,12 +643,21 @@ private:
     //reporting callbacks
     void
     onDigitalReport(
-        Firmata::CallbackEventArgs ^argv_
+        uint8_t port_,
+        uint16_t value_
     );
 
+    //the timestamp is the time the report was received, in the same representation as DateTime::UniversalTime
     void
     onAnalogReport(
-        Firmata::CallbackEventArgs ^argv_
+        uint8_t pin_,
+        uint16_t value_,
+        int64_t timestamp_
+    );
+
+    void
+    onReportBatch(
+        Firmata::ReportBatchEventArgs ^argv_
     );
 
     void
@@ -25,6 +25,10 @@
 #include "pch.h"
 #include "TwoWire.h"
 
+using namespace Concurrency;
+using namespace Windows::Foundation;
+using namespace Windows::Foundation::Collections;
+
 using namespace Microsoft::Maker::Firmata;
 using namespace Microsoft::Maker::RemoteWiring::I2c;
 
@@ -49,6 +53,7 @@ TwoWire::beginTransmission(
     uint8_t address_
     )
 {
+    std::lock_guard<std::mutex> lock( _transmission_mutex );
     if( _address ) return;
     _address = address_;
     _position = 0;
@@ -59,7 +64,8 @@ TwoWire::write(
     uint8_t data_
     )
 {
-    if( !_address || _position > MAX_MESSAGE_LEN ) return;
+    std::lock_guard<std::mutex> lock( _transmission_mutex );
+    if( !_address || _position >= MAX_MESSAGE_LEN ) return;
     _data_buffer.get()[_position] = data_;
     ++_position;
 }
@@ -70,6 +76,7 @@ TwoWire::endTransmission(
     void
     )
 {
+    std::lock_guard<std::mutex> lock( _transmission_mutex );
     if( !_address ) return;
     sendI2cSysex( _address, 0, _position, _data_buffer.get() );
     _address = 0;
@@ -77,11 +84,568 @@ TwoWire::endTransmission(
 }
 
 
+void
+TwoWire::submit(
+    I2cTransaction ^transaction_
+    )
+{
+    if( transaction_ == nullptr || transaction_->_data.empty() ) return;
+
+    //the transaction is copied so the caller may continue to use its instance while the message is sent
+    std::vector<uint8_t> data( transaction_->_data );
+    sendI2cSysex( transaction_->_address, 0, static_cast<uint8_t>( data.size() ), data.data() );
+}
+
+
+void
+TwoWire::requestFrom(
+    uint8_t address_,
+    uint8_t register_,
+    uint8_t numBytes_,
+    bool repeatedStart_
+    )
+{
+    sendRegisterRequest( address_, register_, numBytes_, repeatedStart_ );
+}
+
+IAsyncOperation<Windows::Storage::Streams::IBuffer ^> ^
+TwoWire::readRegisterAsync(
+    uint8_t address_,
+    uint8_t register_,
+    uint8_t numBytes_,
+    bool repeatedStart_
+    )
+{
+    task_completion_event<Windows::Storage::Streams::IBuffer ^> reply;
+    uint16_t key = ( address_ << 8 ) | register_;
+
+    if( !_firmata->connectionReady() )
+    {
+        reply.set( nullptr );
+    }
+    else
+    {
+        uint32_t id = queueRegisterRead( key, reply );
+        if( !sendRegisterRequest( address_, register_, numBytes_, repeatedStart_ ) )
+        {
+            if( cancelRegisterRead( key, id ) ) reply.set( nullptr );
+        }
+        else
+        {
+            //a device which does not acknowledge the read sends no reply, so the read fails once the timeout runs out
+            Platform::WeakReference weak_this( this );
+            TimeSpan timeout;
+            timeout.Duration = REGISTER_READ_TIMEOUT_MILLIS * 10000;
+            Windows::System::Threading::ThreadPoolTimer::CreateTimer( ref new Windows::System::Threading::TimerElapsedHandler( [ weak_this, key, id, reply ]( Windows::System::Threading::ThreadPoolTimer ^timer_ ) -> void
+            {
+                TwoWire ^two_wire = weak_this.Resolve<TwoWire>();
+                if( two_wire != nullptr && two_wire->cancelRegisterRead( key, id ) ) reply.set( nullptr );
+            } ), timeout );
+        }
+    }
+
+    return create_async( [ reply ]() -> task<Windows::Storage::Streams::IBuffer ^> { return create_task( reply ); } );
+}
+
+IAsyncOperation<I2cBlockReadResult ^> ^
+TwoWire::readBlockAsync(
+    uint8_t address_,
+    uint8_t register_,
+    uint32_t length_,
+    bool advanceRegister_,
+    bool repeatedStart_
+    )
+{
+    auto block = std::make_shared<BlockRead>();
+    block->address = address_;
+    block->first_register = register_;
+    block->advance_register = advanceRegister_;
+    block->repeated_start = repeatedStart_;
+    block->data.resize( length_ );
+    block->chunk_count = ( length_ + BLOCK_CHUNK_BYTES - 1 ) / BLOCK_CHUNK_BYTES;
+    block->next_chunk = 0;
+    block->replies = 0;
+    block->finished = false;
+    block->started = std::chrono::steady_clock::now();
+
+    //registers are addressed with a single byte, so an advancing read may not run past the last register
+    if( !length_ || !_firmata->connectionReady() || ( advanceRegister_ && register_ + length_ > 0x100 ) )
+    {
+        block->finished = true;
+        block->result.set( nullptr );
+    }
+    else
+    {
+        //only a few requests are outstanding at once, so the device's receive buffer is not overrun. Each reply requests the next chunk
+        for( size_t i = 0; i < MAX_OUTSTANDING_CHUNKS; ++i )
+        {
+            if( !requestBlockChunk( block ) ) break;
+        }
+    }
+
+    task_completion_event<I2cBlockReadResult ^> result = block->result;
+    return create_async( [ result ]() -> task<I2cBlockReadResult ^> { return create_task( result ); } );
+}
+
+bool
+TwoWire::requestBlockChunk(
+    std::shared_ptr<BlockRead> block_
+    )
+{
+    task_completion_event<Windows::Storage::Streams::IBuffer ^> reply;
+    uint32_t offset;
+    uint8_t num_bytes;
+    uint16_t key;
+    uint32_t id;
+    bool sent;
+
+    {   //critical section
+        std::lock_guard<std::mutex> lock( block_->mutex );
+        if( block_->finished || block_->next_chunk >= block_->chunk_count ) return false;
+
+        offset = block_->next_chunk++ * BLOCK_CHUNK_BYTES;
+        uint32_t length = static_cast<uint32_t>( block_->data.size() );
+        num_bytes = static_cast<uint8_t>( ( length - offset > BLOCK_CHUNK_BYTES ) ? BLOCK_CHUNK_BYTES : length - offset );
+        uint8_t reg = block_->advance_register ? static_cast<uint8_t>( block_->first_register + offset ) : block_->first_register;
+        key = ( block_->address << 8 ) | reg;
+
+        //chunks of the same register are answered in the order they were sent, so the read is queued and sent without releasing the lock
+        id = queueRegisterRead( key, reply );
+        block_->queued.push_back( std::make_pair( key, id ) );
+        sent = sendRegisterRequest( block_->address, reg, num_bytes, block_->repeated_start );
+    }
+
+    if( !sent )
+    {
+        failBlockRead( block_ );
+        return false;
+    }
+
+    //each reply is copied into place as it arrives, a missing reply is withdrawn once the timeout runs out and fails the read
+    Platform::WeakReference weak_this( this );
+    create_task( reply ).then( [ weak_this, block_, offset, num_bytes, key, id ]( Windows::Storage::Streams::IBuffer ^data_ ) -> void
+    {
+        TwoWire ^two_wire = weak_this.Resolve<TwoWire>();
+        if( two_wire != nullptr )
+        {
+            two_wire->onBlockChunk( block_, offset, num_bytes, key, id, data_ );
+            return;
+        }
+
+        //nothing is left to withdraw the remaining chunks from
+        {   //critical section
+            std::lock_guard<std::mutex> lock( block_->mutex );
+            if( block_->finished ) return;
+            block_->finished = true;
+        }
+        block_->result.set( nullptr );
+    } );
+
+    TimeSpan timeout;
+    timeout.Duration = BLOCK_CHUNK_TIMEOUT_MILLIS * 10000;
+    Windows::System::Threading::ThreadPoolTimer::CreateTimer( ref new Windows::System::Threading::TimerElapsedHandler( [ weak_this, key, id, reply ]( Windows::System::Threading::ThreadPoolTimer ^timer_ ) -> void
+    {
+        TwoWire ^two_wire = weak_this.Resolve<TwoWire>();
+        if( two_wire != nullptr && two_wire->cancelRegisterRead( key, id ) ) reply.set( nullptr );
+    } ), timeout );
+
+    return true;
+}
+
+void
+TwoWire::onBlockChunk(
+    std::shared_ptr<BlockRead> block_,
+    uint32_t offset_,
+    uint8_t num_bytes_,
+    uint16_t key_,
+    uint32_t id_,
+    Windows::Storage::Streams::IBuffer ^data_
+    )
+{
+    if( data_ == nullptr || data_->Length < num_bytes_ )
+    {
+        failBlockRead( block_ );
+        return;
+    }
+
+    bool complete;
+    {   //critical section
+        std::lock_guard<std::mutex> lock( block_->mutex );
+        if( block_->finished ) return;
+
+        Windows::Storage::Streams::DataReader::FromBuffer( data_ )->ReadBytes( Platform::ArrayReference<uint8_t>( block_->data.data() + offset_, num_bytes_ ) );
+        block_->queued.erase( std::remove( block_->queued.begin(), block_->queued.end(), std::make_pair( key_, id_ ) ), block_->queued.end() );
+        complete = ( ++block_->replies == block_->chunk_count );
+        block_->finished = complete;
+    }
+
+    if( !complete )
+    {
+        requestBlockChunk( block_ );
+        return;
+    }
+
+    TimeSpan duration;
+    duration.Duration = std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>( std::chrono::steady_clock::now() - block_->started ).count();
+
+    Windows::Storage::Streams::DataWriter ^writer = ref new Windows::Storage::Streams::DataWriter();
+    writer->WriteBytes( Platform::ArrayReference<uint8_t>( block_->data.data(), static_cast<unsigned int>( block_->data.size() ) ) );
+    block_->result.set( ref new I2cBlockReadResult( writer->DetachBuffer(), duration ) );
+}
+
+void
+TwoWire::failBlockRead(
+    std::shared_ptr<BlockRead> block_
+    )
+{
+    std::vector<std::pair<uint16_t, uint32_t>> queued;
+    {   //critical section
+        std::lock_guard<std::mutex> lock( block_->mutex );
+        if( block_->finished ) return;
+        block_->finished = true;
+        queued.swap( block_->queued );
+    }
+
+    for( auto &read : queued )
+    {
+        cancelRegisterRead( read.first, read.second );
+    }
+    block_->result.set( nullptr );
+}
+
+uint16_t
+TwoWire::registerMultiplexedDevice(
+    uint8_t mux_address_,
+    uint8_t channel_,
+    uint8_t address_
+    )
+{
+    if( channel_ >= MAX_MUX_CHANNELS ) return INVALID_DEVICE_ID;
+
+    std::lock_guard<std::mutex> lock( _mux_mutex );
+    if( _mux_devices.size() >= INVALID_DEVICE_ID ) return INVALID_DEVICE_ID;
+
+    MultiplexedDevice device = { mux_address_, channel_, address_ };
+    _mux_devices.push_back( device );
+    return static_cast<uint16_t>( _mux_devices.size() - 1 );
+}
+
+void
+TwoWire::queueRead(
+    uint16_t device_id_,
+    uint8_t numBytes_
+    )
+{
+    std::lock_guard<std::mutex> lock( _mux_mutex );
+    if( device_id_ >= _mux_devices.size() ) return;
+
+    MultiplexedTransaction transaction = { device_id_, true, std::vector<uint8_t>( 1, numBytes_ ) };
+    _mux_queue.push_back( std::move( transaction ) );
+}
+
+void
+TwoWire::queueWrite(
+    uint16_t device_id_,
+    const Platform::Array<uint8_t> ^data_
+    )
+{
+    if( data_ == nullptr || !data_->Length ) return;
+
+    std::lock_guard<std::mutex> lock( _mux_mutex );
+    if( device_id_ >= _mux_devices.size() ) return;
+
+    MultiplexedTransaction transaction = { device_id_, false, std::vector<uint8_t>( data_->Data, data_->Data + data_->Length ) };
+    _mux_queue.push_back( std::move( transaction ) );
+}
+
+void
+TwoWire::sendQueuedTransactions(
+    void
+    )
+{
+    std::lock_guard<std::mutex> lock( _mux_mutex );
+    if( _mux_queue.empty() || !_firmata->connectionReady() ) return;
+
+    //group the transactions by channel, the channel which is already selected is scheduled first so it does not need to be selected again
+    auto group_key = [ this ]( const MultiplexedTransaction &transaction_ ) -> uint32_t
+    {
+        const MultiplexedDevice &device = _mux_devices[transaction_.device_id];
+        auto selected = _mux_selected_channels.find( device.mux_address );
+        bool is_selected = ( selected != _mux_selected_channels.end() && selected->second == ( 1 << device.channel ) );
+        return ( ( is_selected ? 0 : 1 ) << 16 ) | ( device.mux_address << 8 ) | device.channel;
+    };
+    std::stable_sort( _mux_queue.begin(), _mux_queue.end(), [ &group_key ]( const MultiplexedTransaction &a_, const MultiplexedTransaction &b_ ) -> bool
+    {
+        return group_key( a_ ) < group_key( b_ );
+    } );
+
+    //reads are only tracked once the frame holding them has been flushed, so a failed send cannot misattribute later replies
+    std::vector<std::pair<uint8_t, uint16_t>> reads_sent;
+    bool sent = true;
+
+    _firmata->lock();
+    try
+    {
+        for( auto &transaction : _mux_queue )
+        {
+            const MultiplexedDevice &device = _mux_devices[transaction.device_id];
+            uint8_t channel_mask = static_cast<uint8_t>( 1 << device.channel );
+
+            if( _mux_selected_channels[device.mux_address] != channel_mask )
+            {
+                //any other multiplexer with an open channel is closed first, so identical devices behind it do not respond
+                for( auto &mux : _mux_selected_channels )
+                {
+                    if( mux.first == device.mux_address || !mux.second ) continue;
+                    uint8_t none = 0;
+                    writeI2cSysex( mux.first, 0, 1, &none );
+                    mux.second = 0;
+                }
+
+                writeI2cSysex( device.mux_address, 0, 1, &channel_mask );
+                _mux_selected_channels[device.mux_address] = channel_mask;
+            }
+
+            if( transaction.is_read )
+            {
+                writeI2cSysex( device.address, READ_ONCE_MASK, 1, transaction.data.data() );
+                reads_sent.emplace_back( device.address, transaction.device_id );
+            }
+            else
+            {
+                writeI2cSysex( device.address, 0, static_cast<uint8_t>( transaction.data.size() ), transaction.data.data() );
+            }
+        }
+        _firmata->flush();
+    }
+    catch( ... )
+    {
+        //the selected channels are no longer known, and the transactions stay queued so they can be sent by the next call
+        _mux_selected_channels.clear();
+        sent = false;
+    }
+    _firmata->unlock();
+
+    if( !sent ) return;
+
+    for( auto &read : reads_sent )
+    {
+        _mux_reads_in_flight[read.first].push_back( read.second );
+    }
+    _mux_queue.clear();
+}
+
+IAsyncOperation<IVectorView<I2cScanResult ^> ^> ^
+TwoWire::scanAsync(
+    void
+    )
+{
+    return create_async( [ this ]() -> IVectorView<I2cScanResult ^> ^
+    {
+        std::unique_lock<std::mutex> lock( _scan_mutex );
+
+        //only one scan may be in progress at a time
+        _scan_condition.wait( lock, [ this ]() -> bool { return !_scan_active; } );
+        _scan_active = true;
+        _scan_sysex_received = false;
+        _scan_probe_nacked = false;
+        _scan_next_address = MIN_SCAN_ADDRESS;
+        _scan_replies = 0;
+        _scan_pending.reset();
+        _scan_results.clear();
+        _scan_sent_time.fill( std::chrono::steady_clock::now() );
+        lock.unlock();
+
+        //firmware which implements the scan extension will answer with every responding address in a single reply
+        _firmata->lock();
+        try
+        {
+            _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
+            _firmata->write( static_cast<uint8_t>( SysexCommand::I2C_SCAN ) );
+            _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
+            _firmata->flush();
+        }
+        catch( ... )
+        {
+            //something has gone wrong, any fatal errors should be evented
+        }
+        _firmata->unlock();
+
+        lock.lock();
+        if( !_scan_condition.wait_for( lock, SCAN_SYSEX_TIMEOUT, [ this ]() -> bool { return _scan_sysex_received; } ) )
+        {
+            //the extension is not supported, so a one-byte read is pipelined to every address. Each reply will send the next probe
+            std::vector<uint8_t> probes;
+            auto now = std::chrono::steady_clock::now();
+            while( _scan_next_address <= MAX_SCAN_ADDRESS && probes.size() < MAX_OUTSTANDING_PROBES )
+            {
+                _scan_pending.set( _scan_next_address );
+                _scan_sent_time[_scan_next_address] = now;
+                probes.push_back( _scan_next_address++ );
+            }
+            lock.unlock();
+
+            sendScanProbes( probes );
+
+            //the scan ends when every probe has been answered, or when no reply has been received within the timeout
+            lock.lock();
+            size_t replies = _scan_replies;
+            while( _scan_pending.any() )
+            {
+                if( !_scan_condition.wait_for( lock, SCAN_PROBE_TIMEOUT, [ this, replies ]() -> bool { return _scan_replies != replies; } ) ) break;
+                replies = _scan_replies;
+            }
+        }
+
+        auto results = ref new Platform::Collections::Vector<I2cScanResult ^>();
+        for( auto &result : _scan_results )
+        {
+            TimeSpan response_time;
+            response_time.Duration = std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>( result.second ).count();
+            results->Append( ref new I2cScanResult( result.first, response_time ) );
+        }
+
+        _scan_active = false;
+        _scan_pending.reset();
+        _scan_condition.notify_all();
+
+        return results->GetView();
+    } );
+}
+
+
 //******************************************************************************
 //* Private Methods
 //******************************************************************************
 
 void
+TwoWire::onConnectionLost(
+    void
+    )
+{
+    //no reply will arrive for a read in flight, and the device resets its multiplexers along with everything else
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _mux_mutex );
+        _mux_reads_in_flight.clear();
+        _mux_selected_channels.clear();
+    }
+
+    //pending register reads fail, rather than taking replies meant for reads sent once the connection is restored
+    std::map<uint16_t, std::deque<PendingRegisterRead>> register_reads;
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _register_mutex );
+        register_reads.swap( _register_reads );
+    }
+
+    for( auto &pending : register_reads )
+    {
+        for( auto &read : pending.second )
+        {
+            read.reply.set( nullptr );
+        }
+    }
+}
+
+void
+TwoWire::sendScanProbes(
+    const std::vector<uint8_t> &addresses_
+    )
+{
+    if( addresses_.empty() ) return;
+
+    //every probe is a one-byte read, which the device answers even if no device acknowledged the address
+    uint8_t num_bytes = 1;
+
+    _firmata->lock();
+    try
+    {
+        for( uint8_t address : addresses_ )
+        {
+            writeI2cSysex( address, READ_ONCE_MASK, 1, &num_bytes );
+        }
+        _firmata->flush();
+    }
+    catch( ... )
+    {
+        //something has gone wrong, any fatal errors should be evented
+    }
+    _firmata->unlock();
+}
+
+void
+TwoWire::sendShadowWrites(
+    void
+    )
+{
+    std::lock_guard<std::mutex> lock( _shadow_mutex );
+    if( _shadow_writes.empty() ) return;
+
+    //the coalesced writes are sent in a single burst
+    _firmata->lock();
+    try
+    {
+        for( auto &transaction : _shadow_writes )
+        {
+            writeI2cSysex( transaction.first, 0, static_cast<uint8_t>( transaction.second.size() ), transaction.second.data() );
+        }
+        _firmata->flush();
+    }
+    catch( ... )
+    {
+        //the connection was lost again, keep the shadow state so it can be sent on the next attempt
+        _firmata->unlock();
+        return;
+    }
+    _firmata->unlock();
+
+    _shadow_writes.clear();
+}
+
+uint32_t
+TwoWire::queueRegisterRead(
+    uint16_t key_,
+    task_completion_event<Windows::Storage::Streams::IBuffer ^> reply_
+    )
+{
+    std::lock_guard<std::mutex> lock( _register_mutex );
+    PendingRegisterRead read = { _next_register_read_id++, reply_ };
+    _register_reads[key_].push_back( read );
+    return read.id;
+}
+
+bool
+TwoWire::cancelRegisterRead(
+    uint16_t key_,
+    uint32_t id_
+    )
+{
+    std::lock_guard<std::mutex> lock( _register_mutex );
+    auto pending = _register_reads.find( key_ );
+    if( pending == _register_reads.end() ) return false;
+
+    for( auto it = pending->second.begin(); it != pending->second.end(); ++it )
+    {
+        if( it->id != id_ ) continue;
+        pending->second.erase( it );
+        return true;
+    }
+    return false;
+}
+
+bool
+TwoWire::sendRegisterRequest(
+    uint8_t address_,
+    uint8_t register_,
+    uint8_t numBytes_,
+    bool repeatedStart_
+    )
+{
+    //the device writes the register before reading, the reply will carry the same register
+    uint8_t data[] = { register_, numBytes_ };
+    return sendI2cSysex( address_, READ_ONCE_MASK | ( repeatedStart_ ? RESTART_TX_MASK : 0 ), 2, data );
+}
+
+bool
 TwoWire::sendI2cSysex(
     const uint8_t address_,
     const uint8_t rw_mask_,
@@ -89,30 +653,64 @@ TwoWire::sendI2cSysex(
     uint8_t *data_
     )
 {
-    _firmata->lock();
-    try
+    //while the connection is down, write transactions are recorded and sent once the connection is restored. Reads are dropped, as no reply could be received
+    if( !_firmata->connectionReady() )
     {
-        _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
-        _firmata->write( static_cast<uint8_t>( Microsoft::Maker::Firmata::SysexCommand::I2C_REQUEST ) );
-        _firmata->write( address_ );
-        _firmata->write( rw_mask_ );
+        if( rw_mask_ || data_ == nullptr || !len_ ) return false;
 
-        if( data_ != nullptr )
+        std::lock_guard<std::mutex> lock( _shadow_mutex );
+
+        //a write to the same register of the same device supersedes the earlier one, the first data byte is treated as the register
+        for( auto it = _shadow_writes.begin(); it != _shadow_writes.end(); ++it )
         {
-            for( size_t i = 0; i < len_; ++i )
+            if( it->first == address_ && it->second.size() == len_ && it->second.at( 0 ) == data_[0] )
             {
-                _firmata->sendValueAsTwo7bitBytes( data_[i] );
+                _shadow_writes.erase( it );
+                break;
             }
         }
+        _shadow_writes.emplace_back( address_, std::vector<uint8_t>( data_, data_ + len_ ) );
+        return true;
+    }
 
-        _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
+    _firmata->lock();
+    try
+    {
+        writeI2cSysex( address_, rw_mask_, len_, data_ );
         _firmata->flush();
         _firmata->unlock();
     }
     catch( ... )
     {
         _firmata->unlock();
+        return false;
+    }
+    return true;
+}
+
+
+void
+TwoWire::writeI2cSysex(
+    const uint8_t address_,
+    const uint8_t rw_mask_,
+    const uint8_t len_,
+    uint8_t *data_
+    )
+{
+    _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
+    _firmata->write( static_cast<uint8_t>( Microsoft::Maker::Firmata::SysexCommand::I2C_REQUEST ) );
+    _firmata->write( address_ );
+    _firmata->write( rw_mask_ );
+
+    if( data_ != nullptr )
+    {
+        for( size_t i = 0; i < len_; ++i )
+        {
+            _firmata->sendValueAsTwo7bitBytes( data_[i] );
+        }
     }
+
+    _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
 }
 
 
@@ -121,5 +719,119 @@ TwoWire::onI2cReply(
     I2cCallbackEventArgs ^args
     )
 {
+    uint8_t address = args->getAddress();
+    std::vector<uint8_t> next_probe;
+
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _scan_mutex );
+
+        if( _scan_active && address <= MAX_SCAN_ADDRESS && _scan_pending.test( address ) )
+        {
+            //the device reports a missing acknowledgement as a string message immediately before the reply
+            auto now = std::chrono::steady_clock::now();
+            if( !_scan_probe_nacked )
+            {
+                _scan_results[address] = now - _scan_sent_time[address];
+            }
+            _scan_probe_nacked = false;
+            _scan_pending.reset( address );
+            ++_scan_replies;
+
+            //keep the pipeline full
+            if( _scan_next_address <= MAX_SCAN_ADDRESS )
+            {
+                _scan_pending.set( _scan_next_address );
+                _scan_sent_time[_scan_next_address] = now;
+                next_probe.push_back( _scan_next_address++ );
+            }
+
+            _scan_condition.notify_all();
+        }
+        else
+        {
+            address = 0;
+        }
+    }
+
+    //replies to scan probes are consumed by the scan
+    if( address )
+    {
+        sendScanProbes( next_probe );
+        return;
+    }
+
+    //replies to register reads complete the oldest pending read of that register
+    {   //critical section
+        std::unique_lock<std::mutex> lock( _register_mutex );
+        auto pending = _register_reads.find( ( args->getAddress() << 8 ) | args->getRegister() );
+        if( pending != _register_reads.end() && !pending->second.empty() )
+        {
+            task_completion_event<Windows::Storage::Streams::IBuffer ^> reply = pending->second.front().reply;
+            pending->second.pop_front();
+            lock.unlock();
+
+            reply.set( args->getDataBuffer() );
+            return;
+        }
+    }
+
+    //replies to multiplexed reads are matched to their device in the order the reads were sent
+    uint16_t device_id = INVALID_DEVICE_ID;
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _mux_mutex );
+        auto in_flight = _mux_reads_in_flight.find( args->getAddress() );
+        if( in_flight != _mux_reads_in_flight.end() && !in_flight->second.empty() )
+        {
+            device_id = in_flight->second.front();
+            in_flight->second.pop_front();
+        }
+    }
+
+    if( device_id != INVALID_DEVICE_ID )
+    {
+        I2cDeviceReplyEvent( device_id, args->getRegister(), Windows::Storage::Streams::DataReader::FromBuffer( args->getDataBuffer() ) );
+        return;
+    }
+
     I2cReplyEvent( args->getAddress(), args->getRegister(), Windows::Storage::Streams::DataReader::FromBuffer( args->getDataBuffer() ) );
 }
+
+
+void
+TwoWire::onStringMessage(
+    StringCallbackEventArgs ^args
+    )
+{
+    static const wchar_t NACK_MESSAGE[] = L"I2C: Too few bytes received";
+
+    std::lock_guard<std::mutex> lock( _scan_mutex );
+    if( _scan_active && args->getString() != nullptr && !wcsncmp( args->getString()->Data(), NACK_MESSAGE, wcslen( NACK_MESSAGE ) ) )
+    {
+        _scan_probe_nacked = true;
+    }
+}
+
+
+void
+TwoWire::onSysexMessage(
+    SysexCallbackEventArgs ^args
+    )
+{
+    if( args->getCommand() != static_cast<uint8_t>( SysexCommand::I2C_SCAN ) ) return;
+
+    std::lock_guard<std::mutex> lock( _scan_mutex );
+    if( !_scan_active ) return;
+
+    //the scan reply contains one byte for each responding address
+    auto now = std::chrono::steady_clock::now();
+    Windows::Storage::Streams::DataReader ^reader = Windows::Storage::Streams::DataReader::FromBuffer( args->getDataBuffer() );
+    while( reader->UnconsumedBufferLength )
+    {
+        uint8_t address = reader->ReadByte() & 0x7F;
+        if( address > MAX_SCAN_ADDRESS ) continue;
+        _scan_results[address] = now - _scan_sent_time[address];
+    }
+
+    _scan_sysex_received = true;
+    _scan_condition.notify_all();
+}
@@ -22,7 +22,14 @@
     THE SOFTWARE.
 */
 
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
 
 namespace Microsoft {
 namespace Maker {
@@ -32,7 +39,180 @@ ref class RemoteDevice;
 
 namespace I2c {
 
+ref class TwoWire;
+
 public delegate void I2cReplyCallback( uint8_t address_, uint8_t reg_, Windows::Storage::Streams::DataReader ^response );
+public delegate void I2cDeviceReplyCallback( uint16_t device_id_, uint8_t reg_, Windows::Storage::Streams::DataReader ^response );
+
+/*
+ * This class builds a single I2C write transaction. Each caller builds its own instance, which is then sent atomically with TwoWire::submit,
+ * so any number of threads may build and submit transactions concurrently. An instance should not be shared between threads while it is being built.
+ */
+public ref class I2cTransaction sealed
+{
+public:
+    friend ref class TwoWire;
+
+    I2cTransaction(
+        uint8_t address_
+        ) :
+        _address( address_ )
+    {
+    }
+
+    property uint8_t Address
+    {
+        uint8_t get()
+        {
+            return _address;
+        }
+    }
+
+    ///<summary>
+    ///Appends raw byte data to the transaction. Data beyond the maximum message length is ignored.
+    ///</summary>
+    void
+    write(
+        uint8_t data_
+        )
+    {
+        if( _data.size() >= MAX_MESSAGE_LEN ) return;
+        _data.push_back( data_ );
+    }
+
+private:
+    //limited by the sysex buffer of the firmware, matches the limit of TwoWire::write
+    static const size_t MAX_MESSAGE_LEN = 15;
+
+    uint8_t _address;
+    std::vector<uint8_t> _data;
+};
+
+//a register read awaiting a reply, the identifier allows a read which has failed to be withdrawn
+struct PendingRegisterRead
+{
+    uint32_t id;
+    Concurrency::task_completion_event<Windows::Storage::Streams::IBuffer ^> reply;
+};
+
+//a device which sits behind a channel of an I2C multiplexer
+struct MultiplexedDevice
+{
+    uint8_t mux_address;
+    uint8_t channel;
+    uint8_t address;
+};
+
+//a transaction which is waiting to be scheduled, a read transaction holds the number of bytes to read as its only data byte
+struct MultiplexedTransaction
+{
+    uint16_t device_id;
+    bool is_read;
+    std::vector<uint8_t> data;
+};
+
+/*
+ * This class represents a device which responded to a bus scan, and the time it took to respond.
+ */
+public ref class I2cScanResult sealed
+{
+public:
+    friend ref class TwoWire;
+
+    property uint8_t Address
+    {
+        uint8_t get()
+        {
+            return _address;
+        }
+    }
+
+    property Windows::Foundation::TimeSpan ResponseTime
+    {
+        Windows::Foundation::TimeSpan get()
+        {
+            return _response_time;
+        }
+    }
+
+private:
+    I2cScanResult(
+        uint8_t address_,
+        Windows::Foundation::TimeSpan response_time_
+        ) :
+        _address( address_ ),
+        _response_time( response_time_ )
+    {
+    }
+
+    uint8_t _address;
+    Windows::Foundation::TimeSpan _response_time;
+};
+
+/*
+ * This class holds the data returned by a block read and the effective rate at which it was transferred.
+ */
+public ref class I2cBlockReadResult sealed
+{
+public:
+    friend ref class TwoWire;
+
+    property Windows::Storage::Streams::IBuffer ^ Data
+    {
+        Windows::Storage::Streams::IBuffer ^ get()
+        {
+            return _data;
+        }
+    }
+
+    property Windows::Foundation::TimeSpan Duration
+    {
+        Windows::Foundation::TimeSpan get()
+        {
+            return _duration;
+        }
+    }
+
+    property double BytesPerSecond
+    {
+        double get()
+        {
+            return ( _duration.Duration > 0 ) ? ( _data->Length * 10000000.0 ) / _duration.Duration : 0;
+        }
+    }
+
+private:
+    I2cBlockReadResult(
+        Windows::Storage::Streams::IBuffer ^data_,
+        Windows::Foundation::TimeSpan duration_
+        ) :
+        _data( data_ ),
+        _duration( duration_ )
+    {
+    }
+
+    Windows::Storage::Streams::IBuffer ^_data;
+    Windows::Foundation::TimeSpan _duration;
+};
+
+//the progress of a block read, shared with the continuations which copy each chunk into place and request the next one
+struct BlockRead
+{
+    std::mutex mutex;
+    uint8_t address;
+    uint8_t first_register;
+    bool advance_register;
+    bool repeated_start;
+    std::vector<uint8_t> data;
+    uint32_t chunk_count;
+    uint32_t next_chunk;
+    uint32_t replies;
+    bool finished;
+    std::chrono::steady_clock::time_point started;
+    //the chunks awaiting a reply, as ( ( address << 8 ) | register, read identifier ) pairs
+    std::vector<std::pair<uint16_t, uint32_t>> queued;
+    Concurrency::task_completion_event<I2cBlockReadResult ^> result;
+};
 
 public ref class TwoWire sealed
 {
@@ -40,6 +220,7 @@ public:
     friend ref class RemoteDevice;
 
     event I2cReplyCallback ^ I2cReplyEvent;
+    event I2cDeviceReplyCallback ^ I2cDeviceReplyEvent;
 
     ///<summary>
     ///Enables I2C with no delay time for requesting a response from the secondary device
@@ -91,6 +272,16 @@ public:
     );
 
 
+    ///<summary>
+    ///Sends the given transaction atomically. Unlike beginTransmission, write and endTransmission, which share a single transaction
+    ///for this instance, transactions built with I2cTransaction may be submitted from any number of threads concurrently.
+    ///</summary>
+    void
+    submit(
+        I2cTransaction ^transaction_
+    );
+
+
     ///<summary>
     ///A one-time read which will request the given number of bytes from the device.
     ///<para>The device's response will be provided in the form of an I2cReplyEvent. You must subscribe
@@ -103,33 +294,213 @@ public:
         uint8_t numBytes_
         ) 
     {
-        sendI2cSysex( address_, 0x08, 1, &numBytes_ );
+        sendI2cSysex( address_, READ_ONCE_MASK, 1, &numBytes_ );
     }
 
+    ///<summary>
+    ///Registers a device which sits behind the given channel of an I2C multiplexer, such as the TCA9548A.
+    ///<para>Transactions for multiplexed devices are queued with queueRead and queueWrite, and replies are raised as an I2cDeviceReplyEvent
+    ///carrying the returned identifier, so identical devices behind different channels can be told apart.</para>
+    ///<param name="mux_address_">The address of the multiplexer</param>
+    ///<param name="channel_">The multiplexer channel [0-7] the device is connected to</param>
+    ///<param name="address_">The address of the device</param>
+    ///<returns>an identifier for the device, or 0xFFFF if the channel is not valid</returns>
+    ///</summary>
+    uint16_t
+    registerMultiplexedDevice(
+        uint8_t mux_address_,
+        uint8_t channel_,
+        uint8_t address_
+    );
+
+    ///<summary>
+    ///Queues a one-time read of the given number of bytes from a multiplexed device. The transaction is sent by sendQueuedTransactions.
+    ///</summary>
+    void
+    queueRead(
+        uint16_t device_id_,
+        uint8_t numBytes_
+    );
+
+    ///<summary>
+    ///Queues a write of the given bytes to a multiplexed device. The transaction is sent by sendQueuedTransactions.
+    ///</summary>
+    void
+    queueWrite(
+        uint16_t device_id_,
+        const Platform::Array<uint8_t> ^data_
+    );
+
+    ///<summary>
+    ///Sends every queued transaction in a single flush. Transactions are grouped by multiplexer channel, starting with the channel which is
+    ///already selected, and a channel select write is only sent when the channel changes. Transactions for the same device keep their order.
+    ///</summary>
+    void
+    sendQueuedTransactions(
+        void
+    );
+
+    ///<summary>
+    ///Scans the bus for every responding device in the valid address range [0x08-0x77].
+    ///<para>If the firmware supports the I2C_SCAN extension, the scan is performed by the device with a single request. Otherwise,
+    ///a one-byte read is pipelined to every address and the devices which acknowledge it are reported along with their response time.</para>
+    ///<para>While a scan is in progress, replies to the scan probes will not be raised as an I2cReplyEvent.</para>
+    ///</summary>
+    Windows::Foundation::IAsyncOperation<Windows::Foundation::Collections::IVectorView<I2cScanResult ^> ^> ^
+    scanAsync(
+        void
+    );
+
+    ///<summary>
+    ///A one-time read which will request the given number of bytes from the given register of the device with a single request.
+    ///<para>The register is written and read back by the device, so no separate write transaction is required. The device's response
+    ///will be provided in the form of an I2cReplyEvent.</para>
+    ///<param name="repeatedStart_">If true, the bus is not released between writing the register and reading the data</param>
+    ///</summary>
+    void
+    requestFrom(
+        uint8_t address_,
+        uint8_t register_,
+        uint8_t numBytes_,
+        bool repeatedStart_
+    );
+
+    ///<summary>
+    ///Reads the given number of bytes from the given register of the device with a single request, and completes with the device's reply.
+    ///<para>The reply is not raised as an I2cReplyEvent. If the request cannot be sent, no reply arrives within the timeout, as when the device
+    ///does not acknowledge the read, or the connection is lost, the operation completes with nullptr.</para>
+    ///<param name="repeatedStart_">If true, the bus is not released between writing the register and reading the data</param>
+    ///</summary>
+    Windows::Foundation::IAsyncOperation<Windows::Storage::Streams::IBuffer ^> ^
+    readRegisterAsync(
+        uint8_t address_,
+        uint8_t register_,
+        uint8_t numBytes_,
+        bool repeatedStart_
+    );
+
+    ///<summary>
+    ///Reads a block of any length from the device, starting at the given register, and completes with the whole block once it has arrived.
+    ///<para>The read is split into requests the firmware can answer in a single reply, which are pipelined and reassembled in order. None of the
+    ///replies are raised as an I2cReplyEvent. If a request cannot be sent or a reply does not arrive, the operation completes with nullptr.</para>
+    ///<param name="length_">The number of bytes to read</param>
+    ///<param name="advanceRegister_">If true, each request starts at the register following the previous one, as for a memory page.
+    ///Otherwise every request reads the same register, as for a FIFO. An advancing read which would run past register 0xFF completes with nullptr.</param>
+    ///<param name="repeatedStart_">If true, the bus is not released between writing the register and reading the data</param>
+    ///</summary>
+    Windows::Foundation::IAsyncOperation<I2cBlockReadResult ^> ^
+    readBlockAsync(
+        uint8_t address_,
+        uint8_t register_,
+        uint32_t length_,
+        bool advanceRegister_,
+        bool repeatedStart_
+    );
+
 private:
     //since 16 bit values are sent as two 7 bit bytes, you can't send a value larger than this across the wire
     const uint16_t MAX_READ_DELAY_MICROS = 0x3FFF;
     const size_t MAX_MESSAGE_LEN = 15;
 
+    //bus scan constants, the number of outstanding probes is limited so the device's receive buffer is not overrun
+    static const uint8_t MIN_SCAN_ADDRESS = 0x08;
+    static const uint8_t MAX_SCAN_ADDRESS = 0x77;
+    static const size_t MAX_OUTSTANDING_PROBES = 8;
+    const std::chrono::milliseconds SCAN_SYSEX_TIMEOUT = std::chrono::milliseconds( 50 );
+    const std::chrono::milliseconds SCAN_PROBE_TIMEOUT = std::chrono::milliseconds( 250 );
+
+    //block read constants, each reply must fit the firmware's 64 byte sysex buffer with every data byte sent as two 7 bit bytes
+    static const uint32_t BLOCK_CHUNK_BYTES = 28;
+    static const size_t MAX_OUTSTANDING_CHUNKS = 4;
+    static const int64_t BLOCK_CHUNK_TIMEOUT_MILLIS = 250;
+
+    //a register read which has not been answered within this time has failed
+    static const int64_t REGISTER_READ_TIMEOUT_MILLIS = 500;
+
+    //I2C request mode bits
+    static const uint8_t READ_ONCE_MASK = 0x08;
+    static const uint8_t RESTART_TX_MASK = 0x40;
+
+    //multiplexer constants
+    static const uint8_t MAX_MUX_CHANNELS = 8;
+    static const uint16_t INVALID_DEVICE_ID = 0xFFFF;
+
     //singleton pattern w/ friend class to instantiate
     TwoWire(
         Firmata::UwpFirmata ^ firmata_
         ) :
         _data_buffer( new uint8_t[ MAX_MESSAGE_LEN ] ),
-        _firmata( firmata_ )
+        _firmata( firmata_ ),
+        _address( 0 ),
+        _position( 0 ),
+        _scan_active( false ),
+        _scan_sysex_received( false ),
+        _scan_probe_nacked( false ),
+        _scan_next_address( 0 ),
+        _scan_replies( 0 ),
+        _next_register_read_id( 0 )
     {
         _firmata->I2cReplyReceived += ref new Firmata::I2cReplyCallbackFunction( [this]( Firmata::UwpFirmata ^caller, Firmata::I2cCallbackEventArgs^ args ) -> void { onI2cReply( args ); } );
+        _firmata->SysexMessageReceived += ref new Firmata::SysexCallbackFunction( [this]( Firmata::UwpFirmata ^caller, Firmata::SysexCallbackEventArgs^ args ) -> void { onSysexMessage( args ); } );
+        _firmata->StringMessageReceived += ref new Firmata::StringCallbackFunction( [this]( Firmata::UwpFirmata ^caller, Firmata::StringCallbackEventArgs^ args ) -> void { onStringMessage( args ); } );
     }
     
     //a reference to the UAP firmata interface
     Firmata::UwpFirmata ^_firmata;
 
-    //transmission-building variables
+    //transmission-building variables, guarded by _transmission_mutex
+    std::mutex _transmission_mutex;
     uint8_t _address;
     uint8_t _position;
     std::unique_ptr<uint8_t> _data_buffer;
 
+    //shadow state, holds the write transactions requested while the connection was down as ( address, data ) pairs
+    std::mutex _shadow_mutex;
+    std::vector<std::pair<uint8_t, std::vector<uint8_t>>> _shadow_writes;
+
+    //multiplexer state, guarded by _mux_mutex. K = multiplexer address, V = bitmask of the selected channel (0 if none)
+    std::mutex _mux_mutex;
+    std::vector<MultiplexedDevice> _mux_devices;
+    std::vector<MultiplexedTransaction> _mux_queue;
+    std::map<uint8_t, uint8_t> _mux_selected_channels;
+    //K = device address, V = the multiplexed devices with a read in flight to that address, in the order they were sent
+    std::map<uint8_t, std::deque<uint16_t>> _mux_reads_in_flight;
+
+    //pending register reads, guarded by _register_mutex. K = ( address << 8 ) | register, V = the reads awaiting a reply in the order they were sent
+    std::mutex _register_mutex;
+    std::map<uint16_t, std::deque<PendingRegisterRead>> _register_reads;
+    uint32_t _next_register_read_id;
+
+    //bus scan state, guarded by _scan_mutex
+    std::mutex _scan_mutex;
+    std::condition_variable _scan_condition;
+    bool _scan_active;
+    bool _scan_sysex_received;
+    bool _scan_probe_nacked;
+    uint8_t _scan_next_address;
+    size_t _scan_replies;
+    std::bitset<MAX_SCAN_ADDRESS + 1> _scan_pending;
+    std::array<std::chrono::steady_clock::time_point, MAX_SCAN_ADDRESS + 1> _scan_sent_time;
+    std::map<uint8_t, std::chrono::steady_clock::duration> _scan_results;
+
+    //forgets the state which cannot survive a lost connection, called by RemoteDevice
+    void
+    onConnectionLost(
+        void
+    );
+
+    void
+    sendScanProbes(
+        const std::vector<uint8_t> &addresses_
+    );
+
     void
+    sendShadowWrites(
+        void
+    );
+
+    //returns true if the message was sent, or recorded to be sent once the connection is restored
+    bool
     sendI2cSysex(
         const uint8_t address_,
         const uint8_t rw_mask_,
@@ -137,10 +508,74 @@ private:
         uint8_t *data_
     );
 
+    //adds a read to the reads awaiting a reply from the given ( address << 8 ) | register, returning its identifier
+    uint32_t
+    queueRegisterRead(
+        uint16_t key_,
+        Concurrency::task_completion_event<Windows::Storage::Streams::IBuffer ^> reply_
+    );
+
+    //withdraws a read which is still awaiting a reply, returning false if it has already been answered
+    bool
+    cancelRegisterRead(
+        uint16_t key_,
+        uint32_t id_
+    );
+
+    //requests the next chunk of a block read, returning false once every chunk has been requested or the read has failed
+    bool
+    requestBlockChunk(
+        std::shared_ptr<BlockRead> block_
+    );
+
+    //copies a chunk into place, then completes the block read or requests its next chunk
+    void
+    onBlockChunk(
+        std::shared_ptr<BlockRead> block_,
+        uint32_t offset_,
+        uint8_t num_bytes_,
+        uint16_t key_,
+        uint32_t id_,
+        Windows::Storage::Streams::IBuffer ^data_
+    );
+
+    //completes a block read with nullptr and withdraws every chunk still awaiting a reply, so it cannot consume a later reply of the same register
+    void
+    failBlockRead(
+        std::shared_ptr<BlockRead> block_
+    );
+
+    //sends a request to read the given register, returning false if it could not be sent
+    bool
+    sendRegisterRequest(
+        uint8_t address_,
+        uint8_t register_,
+        uint8_t numBytes_,
+        bool repeatedStart_
+    );
+
+    void
+    writeI2cSysex(
+        const uint8_t address_,
+        const uint8_t rw_mask_,
+        const uint8_t len_,
+        uint8_t *data_
+    );
+
     void
     onI2cReply(
         Firmata::I2cCallbackEventArgs ^argv
     );
+
+    void
+    onStringMessage(
+        Firmata::StringCallbackEventArgs ^argv
+    );
+
+    void
+    onSysexMessage(
+        Firmata::SysexCallbackEventArgs ^argv
+    );
 };
 
 } // namespace I2c